@@ -12,20 +12,20 @@
 #include <atomic>
 
 #include <video_io/video_reader.hpp>
-#include "../utils/simple_frame.hpp"
 #include "../utils/frame_queue.hpp"
 
 #include <GLFW/glfw3.h>
 
 using namespace std::chrono_literals;
 
-void decode_thread(vio::video_reader& v, vio::examples::utils::frame_queue<vio::examples::utils::simple_frame>& frame_queue, bool& is_decoding_required)
+void decode_thread(vio::video_reader& v, vio::examples::utils::frame_queue<vio::frame>& frame_queue, bool& is_decoding_required)
 {
 	int frames_decoded = 0;
 	while(is_decoding_required)
 	{
-		vio::examples::utils::simple_frame frame;
-		if(!v.read(&frame.data, &frame.pts))
+		// vio::frame is refcounted: enqueuing it does not copy pixel data, and the next read() never overwrites it.
+		vio::frame frame;
+		if(!v.read(frame))
 		{
 			std::cout << "Video finished" << std::endl;
 			std::cout << "frames decoded: " << frames_decoded << std::endl;
@@ -77,7 +77,7 @@ bool setup_opengl(GLFWwindow** window, GLuint& texture_handle, int frame_width,
 	return true;
 }
 
-void draw_frame(GLFWwindow *window, GLuint& texture_handle, int frame_width, int frame_height, uint8_t* frame_data)
+void draw_frame(GLFWwindow *window, GLuint& texture_handle, int frame_width, int frame_height, const uint8_t* frame_data)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, frame_width, frame_height, 0, GL_RGB, GL_UNSIGNED_BYTE, frame_data);
@@ -129,7 +129,7 @@ int main(int argc, char **argv)
 	const auto [frame_width, frame_height] = frame_size.value();
 
 	bool is_decoding_required = true;
-	vio::examples::utils::frame_queue<vio::examples::utils::simple_frame> frame_queue(3);
+	vio::examples::utils::frame_queue<vio::frame> frame_queue(3);
 	std::thread t(&decode_thread, std::ref(v), std::ref(frame_queue), std::ref(is_decoding_required));
 
 	GLFWwindow *window = nullptr;
@@ -139,7 +139,7 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 
 	int frames_shown = 0;
-	vio::examples::utils::simple_frame frame;
+	vio::frame frame;
 
 	std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> start_time = std::chrono::steady_clock::now();
 	std::chrono::duration<double> elapsed_time(0.0);
@@ -152,10 +152,10 @@ int main(int argc, char **argv)
 		if(!frame_queue.try_get(&frame) && !is_decoding_required)
 			break;
 
-		if (const auto timeout = frame.pts - get_elapsed_time(); timeout > 0.0)
+		if (const auto timeout = frame.get_pts() - get_elapsed_time(); timeout > 0.0)
 			std::this_thread::sleep_for(std::chrono::duration<double>(timeout));
 
-		draw_frame(window, texture_handle, frame_width, frame_height, frame.data);
+		draw_frame(window, texture_handle, frame_width, frame_height, frame.get_data());
 		++frames_shown;
 	}
 
@@ -0,0 +1,82 @@
+#include "test_async_video_reader.hpp"
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace vio::test
+{
+
+TEST_F(async_video_reader_test, open_valid_path)
+{
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+    ASSERT_TRUE(v->is_opened());
+}
+
+TEST_F(async_video_reader_test, open_non_existing_path)
+{
+    const auto invalid_video_path = default_input_directory / "invalid-path.mp4";
+    ASSERT_FALSE(v->open(invalid_video_path.string().c_str()));
+    ASSERT_FALSE(v->is_opened());
+}
+
+TEST_F(async_video_reader_test, read_without_open)
+{
+    vio::frame f;
+    ASSERT_FALSE(v->read(f));
+    ASSERT_FALSE(v->try_read(f));
+    ASSERT_FALSE(v->release());
+}
+
+TEST_F(async_video_reader_test, read_all_frames)
+{
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+
+    int num_decoded_frames = 0;
+    double previous_pts = -1.0;
+    vio::frame f;
+    while(v->read(f))
+    {
+        ASSERT_EQ(f.get_width(), width);
+        ASSERT_EQ(f.get_height(), height);
+        ASSERT_GT(f.get_pts(), previous_pts);
+        previous_pts = f.get_pts();
+        num_decoded_frames++;
+    }
+
+    ASSERT_EQ(num_decoded_frames, duration * fps);
+}
+
+TEST_F(async_video_reader_test, try_read_eventually_returns_frame)
+{
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+
+    vio::frame f;
+    while(!v->try_read(f))
+        std::this_thread::yield();
+
+    ASSERT_TRUE(f.is_valid());
+}
+
+TEST_F(async_video_reader_test, release_while_decoding)
+{
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+
+    ASSERT_TRUE(v->release());
+    ASSERT_FALSE(v->is_opened());
+    ASSERT_TRUE(f.is_valid());
+}
+
+TEST_F(async_video_reader_test, open_same_path_three_times)
+{
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+    ASSERT_TRUE(v->open(default_video_path.c_str()));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+}
+
+}
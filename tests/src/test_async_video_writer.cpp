@@ -0,0 +1,131 @@
+#include "test_async_video_writer.hpp"
+#include <video_io/video_reader.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace vio::test
+{
+
+static int count_frames(const std::vector<uint8_t>& buffer)
+{
+    vio::video_reader reader;
+    if (!reader.open(buffer.data(), buffer.size()))
+        return -1;
+
+    int num_read_frames = 0;
+    uint8_t* data = nullptr;
+    while(reader.read(&data))
+        num_read_frames++;
+
+    return num_read_frames;
+}
+
+TEST_F(async_video_writer_test, write_without_open)
+{
+    ASSERT_FALSE(v->write(frame_data.data()));
+    ASSERT_FALSE(v->flush().get());
+    ASSERT_FALSE(v->save());
+    ASSERT_FALSE(v->release());
+}
+
+TEST_F(async_video_writer_test, open_invalid_sink)
+{
+    ASSERT_FALSE(v->open(vio::output_sink{}, width, height, fps));
+    ASSERT_FALSE(v->is_opened());
+}
+
+TEST_F(async_video_writer_test, write_n_frames)
+{
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+    ASSERT_TRUE(v->is_opened());
+
+    const int num_frames_to_write = 3 * fps;
+    for (int i = 0; i < num_frames_to_write; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    ASSERT_TRUE(v->save());
+    ASSERT_FALSE(v->is_opened());
+    ASSERT_EQ(v->get_dropped_frames(), 0u);
+    ASSERT_EQ(count_frames(buffer), num_frames_to_write);
+}
+
+TEST_F(async_video_writer_test, flush_pushes_packets_to_sink)
+{
+    size_t num_bytes_written = 0;
+    vio::output_sink sink{ "mp4", 4096, true };
+    sink.write = [&num_bytes_written](const uint8_t*, int size)
+    {
+        num_bytes_written += size;
+        return size;
+    };
+
+    ASSERT_TRUE(v->open(sink, width, height, fps));
+    for (int i = 0; i < fps; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    auto is_flushed = v->flush();
+    ASSERT_TRUE(is_flushed.get());
+    ASSERT_GT(num_bytes_written, 0u);
+
+    // The writer keeps accepting frames after a flush.
+    ASSERT_TRUE(v->write(frame_data.data()));
+    ASSERT_TRUE(v->save());
+}
+
+TEST_F(async_video_writer_test, release_resolves_pending_flush)
+{
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+    for (int i = 0; i < fps; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    auto is_flushed = v->flush();
+    ASSERT_TRUE(v->release());
+    ASSERT_FALSE(v->is_opened());
+
+    // Either flushed before the release or dropped with the pending frames, never left unresolved.
+    is_flushed.wait();
+}
+
+TEST_F(async_video_writer_test, drop_newest_when_queue_is_full)
+{
+    v = std::make_unique<vio::async_video_writer>(1, vio::backpressure_policy::drop_newest);
+
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+
+    const int num_frames_to_write = 5 * fps;
+    int num_queued_frames = 0;
+    for (int i = 0; i < num_frames_to_write; ++i)
+    {
+        if (v->write(frame_data.data()))
+            num_queued_frames++;
+    }
+
+    ASSERT_EQ(num_queued_frames + static_cast<int>(v->get_dropped_frames()), num_frames_to_write);
+    ASSERT_TRUE(v->save());
+    ASSERT_EQ(count_frames(buffer), num_queued_frames);
+}
+
+TEST_F(async_video_writer_test, drop_oldest_when_queue_is_full)
+{
+    v = std::make_unique<vio::async_video_writer>(1, vio::backpressure_policy::drop_oldest);
+
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+
+    const int num_frames_to_write = 5 * fps;
+    for (int i = 0; i < num_frames_to_write; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    // Flush markers are never dropped.
+    ASSERT_TRUE(v->flush().get());
+
+    const auto num_dropped_frames = static_cast<int>(v->get_dropped_frames());
+    ASSERT_TRUE(v->save());
+    ASSERT_EQ(count_frames(buffer), num_frames_to_write - num_dropped_frames);
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+#include <video_io/async_video_writer.hpp>
+
+#include <array>
+
+namespace vio::test
+{
+
+class async_video_writer_test : public ::testing::Test
+{
+protected:
+    explicit async_video_writer_test()
+    : v{ std::make_unique<vio::async_video_writer>(queue_depth) }
+    , test_name { testing::UnitTest::GetInstance()->current_test_info()->name() }
+    {
+        frame_data.fill(static_cast<uint8_t>(0));
+    }
+
+    virtual ~async_video_writer_test() { v->release(); }
+
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+
+    static const size_t queue_depth = 4;
+    std::unique_ptr<vio::async_video_writer> v;
+    const std::string test_name;
+
+    static const int fps = 30;
+    static const int width = 640;
+    static const int height = 480;
+
+    static const int frame_size = width * height * 3;
+    std::array<uint8_t, frame_size> frame_data = { };
+};
+
+}
@@ -0,0 +1,128 @@
+#include "test_decode_scheduler.hpp"
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace vio::test
+{
+
+TEST_F(decode_scheduler_test, add_stream_valid_path)
+{
+    const auto stream_id = s->add_stream(default_video_path.c_str());
+    ASSERT_TRUE(stream_id.has_value());
+    ASSERT_EQ(s->get_stream_count(), 1);
+    ASSERT_EQ(s->get_worker_count(), worker_count);
+
+    const auto [frame_width, frame_height] = s->get_frame_size(stream_id.value()).value();
+    ASSERT_EQ(frame_width, width);
+    ASSERT_EQ(frame_height, height);
+    ASSERT_EQ(s->get_fps(stream_id.value()).value(), fps);
+}
+
+TEST_F(decode_scheduler_test, add_stream_non_existing_path)
+{
+    const auto invalid_video_path = default_input_directory / "invalid-path.mp4";
+    ASSERT_FALSE(s->add_stream(invalid_video_path.string().c_str()).has_value());
+    ASSERT_EQ(s->get_stream_count(), 0);
+}
+
+TEST_F(decode_scheduler_test, read_invalid_stream)
+{
+    vio::frame f;
+    ASSERT_FALSE(s->read(0, f));
+    ASSERT_FALSE(s->try_read(0, f));
+    ASSERT_FALSE(s->remove_stream(0));
+    ASSERT_FALSE(s->set_priority(0, vio::stream_priority::high));
+}
+
+TEST_F(decode_scheduler_test, read_all_frames_of_many_streams)
+{
+    const int stream_count = 8;
+    std::vector<int> stream_ids;
+    for (int i = 0; i < stream_count; ++i)
+        stream_ids.push_back(s->add_stream(default_video_path.c_str(), vio::decode_support::SW, {}, 
+            i == 0 ? vio::stream_priority::high : vio::stream_priority::normal).value());
+
+    std::vector<int> num_decoded_frames(stream_count, 0);
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < stream_count; ++i)
+    {
+        consumers.emplace_back([this, &stream_ids, &num_decoded_frames, i]
+        {
+            double previous_pts = -1.0;
+            vio::frame f;
+            while(s->read(stream_ids[i], f))
+            {
+                if (f.get_pts() > previous_pts)
+                    num_decoded_frames[i]++;
+
+                previous_pts = f.get_pts();
+            }
+        });
+    }
+
+    for (auto& consumer : consumers)
+        consumer.join();
+
+    for (int i = 0; i < stream_count; ++i)
+        ASSERT_EQ(num_decoded_frames[i], duration * fps);
+}
+
+TEST_F(decode_scheduler_test, remove_stream_while_decoding)
+{
+    const auto stream_id = s->add_stream(default_video_path.c_str()).value();
+
+    vio::frame f;
+    ASSERT_TRUE(s->read(stream_id, f));
+    ASSERT_TRUE(s->remove_stream(stream_id));
+    ASSERT_FALSE(s->read(stream_id, f));
+    ASSERT_EQ(s->get_stream_count(), 0);
+    ASSERT_TRUE(f.is_valid());
+}
+
+TEST_F(decode_scheduler_test, release_while_decoding)
+{
+    const auto stream_id = s->add_stream(default_video_path.c_str()).value();
+
+    vio::frame f;
+    ASSERT_TRUE(s->read(stream_id, f));
+    ASSERT_TRUE(s->release());
+    ASSERT_FALSE(s->read(stream_id, f));
+    ASSERT_FALSE(s->add_stream(default_video_path.c_str()).has_value());
+    ASSERT_FALSE(s->release());
+}
+
+TEST_F(decode_scheduler_test, release_while_reading)
+{
+    const int stream_count = 4;
+    std::vector<int> stream_ids;
+    for (int i = 0; i < stream_count; ++i)
+        stream_ids.push_back(s->add_stream(default_video_path.c_str()).value());
+
+    // Consumers keep rescheduling their streams while the scheduler is released.
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < stream_count; ++i)
+    {
+        consumers.emplace_back([this, &stream_ids, i]
+        {
+            vio::frame f;
+            while(s->read(stream_ids[i], f) || s->try_read(stream_ids[i], f));
+        });
+    }
+
+    std::thread adder([this]
+    {
+        while(s->add_stream(default_video_path.c_str()).has_value());
+    });
+
+    ASSERT_TRUE(s->release());
+
+    for (auto& consumer : consumers)
+        consumer.join();
+
+    adder.join();
+    ASSERT_EQ(s->get_stream_count(), 0);
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+#include <video_io/decode_scheduler.hpp>
+
+#include <filesystem>
+
+namespace vio::test
+{
+
+class decode_scheduler_test : public ::testing::Test
+{
+protected:
+    explicit decode_scheduler_test()
+    : s{ std::make_unique<vio::decode_scheduler>(worker_count, queue_depth) }
+    , test_name { testing::UnitTest::GetInstance()->current_test_info()->name() }
+    , default_input_directory{ std::filesystem::current_path() / "../../../tests/data/new" }
+    , default_video_extension { ".mp4" }
+    , default_video_name { "testsrc2_3sec_30fps_640x480" }
+    , default_video_path { (default_input_directory / default_video_name).replace_extension(default_video_extension).string() }
+    { }
+
+    virtual ~decode_scheduler_test() { s->release(); }
+
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+
+    static const size_t worker_count = 4;
+    static const size_t queue_depth = 4;
+    std::unique_ptr<vio::decode_scheduler> s;
+    const std::string test_name;
+    const std::filesystem::path default_input_directory;
+    const std::string default_video_extension;
+    const std::string default_video_name;
+    const std::string default_video_path;
+
+    static const int fps = 30;
+    static const int width = 640;
+    static const int height = 480;
+    static const int duration = 3;
+};
+
+}
@@ -1,5 +1,10 @@
 #include "test_video_reader.hpp"
 #include <gtest/gtest.h>
+#include <video_io/video_writer.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
 
 namespace vio::test
 {
@@ -80,6 +85,655 @@ TEST_F(video_reader_test, open_three_different_paths)
     ASSERT_TRUE(v->is_opened());
 }
 
+TEST_F(video_reader_test, read_frame_handle)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->is_opened());
+
+    vio::frame f;
+    ASSERT_FALSE(f.is_valid());
+    ASSERT_TRUE(v->read(f));
+    ASSERT_TRUE(f.is_valid());
+    ASSERT_EQ(f.get_width(), width);
+    ASSERT_EQ(f.get_height(), height);
+    ASSERT_NE(f.get_data(), nullptr);
+}
+
+TEST_F(video_reader_test, read_frame_handle_outlives_next_read)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->is_opened());
+
+    vio::frame first;
+    ASSERT_TRUE(v->read(first));
+    const uint8_t* first_data = first.get_data();
+    const double first_pts = first.get_pts();
+
+    vio::frame second;
+    ASSERT_TRUE(v->read(second));
+
+    ASSERT_EQ(first.get_data(), first_data);
+    ASSERT_EQ(first.get_pts(), first_pts);
+    ASSERT_NE(second.get_data(), first_data);
+    ASSERT_GT(second.get_pts(), first_pts);
+}
+
+TEST_F(video_reader_test, frame_handle_copy_shares_data)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+
+    vio::frame copy = f;
+    ASSERT_EQ(copy.get_data(), f.get_data());
+
+    vio::frame moved = std::move(f);
+    ASSERT_FALSE(f.is_valid());
+    ASSERT_EQ(moved.get_data(), copy.get_data());
+
+    ASSERT_TRUE(v->release());
+    ASSERT_TRUE(copy.is_valid());
+}
+
+TEST_F(video_reader_test, read_native_format)
+{
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, vio::pixel_format::native));
+    ASSERT_TRUE(v->is_opened());
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_EQ(f.get_width(), width);
+    ASSERT_EQ(f.get_height(), height);
+
+    // testsrc2 clips are encoded as YUV420P: three planes, full resolution luma
+    ASSERT_NE(f.get_data(0), nullptr);
+    ASSERT_NE(f.get_data(1), nullptr);
+    ASSERT_NE(f.get_data(2), nullptr);
+    ASSERT_GE(f.get_linesize(0), width);
+
+    const auto frame_size_in_bytes = v->get_frame_size_in_bytes();
+    ASSERT_TRUE(frame_size_in_bytes.has_value());
+    ASSERT_EQ(frame_size_in_bytes.value(), width * height * 3 / 2);
+}
+
+TEST_F(video_reader_test, read_scaled_output)
+{
+    const vio::output_spec output{ vio::pixel_format::rgb24, 224, 224, vio::scale_algorithm::area };
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, output));
+    ASSERT_TRUE(v->is_opened());
+
+    const auto [output_width, output_height] = v->get_frame_size().value();
+    ASSERT_EQ(output_width, 224);
+    ASSERT_EQ(output_height, 224);
+    ASSERT_EQ(v->get_frame_size_in_bytes().value(), 224 * 224 * 3);
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_EQ(f.get_width(), 224);
+    ASSERT_EQ(f.get_height(), 224);
+    ASSERT_EQ(f.get_linesize(0), 224 * 3);
+}
+
+TEST_F(video_reader_test, read_threaded_conversion)
+{
+    const vio::output_spec output{ vio::pixel_format::rgb24, 224, 224, vio::scale_algorithm::bilinear, 4 };
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, output));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_EQ(f.get_width(), 224);
+    ASSERT_EQ(f.get_height(), 224);
+
+    std::vector<uint8_t> batch(2 * v->get_frame_size_in_bytes().value());
+    ASSERT_EQ(v->read_batch(2, 1, batch.data()), 2);
+}
+
+TEST_F(video_reader_test, read_gray_output_keeps_source_size)
+{
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, vio::output_spec{ vio::pixel_format::gray8 }));
+    ASSERT_EQ(v->get_frame_size_in_bytes().value(), width * height);
+
+    uint8_t* data_buffer = nullptr;
+    ASSERT_TRUE(v->read(&data_buffer));
+    ASSERT_NE(data_buffer, nullptr);
+}
+
+TEST_F(video_reader_test, open_invalid_output_size)
+{
+    ASSERT_FALSE(v->open(default_video_path, vio::decode_support::SW, vio::output_spec{ vio::pixel_format::rgb24, -1, 224 }));
+    ASSERT_FALSE(v->is_opened());
+}
+
+TEST_F(video_reader_test, seek_precise)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->seek(std::chrono::seconds(1), vio::seek_mode::precise));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), 1.0, 0.5 / fps);
+}
+
+TEST_F(video_reader_test, seek_keyframe)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->seek(std::chrono::milliseconds(2500), vio::seek_mode::keyframe));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_LE(f.get_pts(), 2.5);
+}
+
+TEST_F(video_reader_test, seek_frame_precise)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->seek_frame(45));
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), 45.0 / fps, 0.5 / fps);
+
+    ASSERT_TRUE(v->seek_frame(0));
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), 0.0, 0.5 / fps);
+}
+
+TEST_F(video_reader_test, seek_with_start_time)
+{
+    // MPEG-TS timestamps do not start at 0: seek positions are on the same timeline as the frame pts.
+    const auto ts_path = (std::filesystem::temp_directory_path() / test_name).replace_extension(".ts");
+    {
+        const int width = 320, height = 240;
+        std::vector<uint8_t> frame_data(width * height * 3, 0);
+
+        vio::video_writer writer;
+        ASSERT_TRUE(writer.open(ts_path.string(), width, height, fps));
+        for (int i = 0; i < 3 * fps; ++i)
+            ASSERT_TRUE(writer.write(frame_data.data()));
+        ASSERT_TRUE(writer.save());
+    }
+
+    vio::frame f;
+    ASSERT_TRUE(v->open(ts_path.string().c_str()));
+    ASSERT_TRUE(v->read(f));
+    const double start_pts = f.get_pts();
+    ASSERT_GT(start_pts, 0.0);
+
+    ASSERT_TRUE(v->seek(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(start_pts + 1.0))));
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), start_pts + 1.0, 0.5 / fps);
+
+    ASSERT_TRUE(v->seek_frame(0));
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), start_pts, 0.5 / fps);
+
+    v->release();
+    std::filesystem::remove(ts_path);
+}
+
+TEST_F(video_reader_test, seek_past_end)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_FALSE(v->seek(std::chrono::seconds(60)));
+}
+
+TEST_F(video_reader_test, seek_without_open)
+{
+    ASSERT_FALSE(v->seek(std::chrono::seconds(1)));
+    ASSERT_FALSE(v->seek_frame(1));
+}
+
+TEST_F(video_reader_test, build_keyframe_index)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_FALSE(v->get_keyframe_count().has_value());
+
+    ASSERT_TRUE(v->build_keyframe_index());
+    ASSERT_TRUE(v->get_keyframe_count().has_value());
+    ASSERT_GT(v->get_keyframe_count().value(), 0);
+
+    // Building the index rewinds the reader to the first frame
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), 0.0, 0.5 / fps);
+}
+
+TEST_F(video_reader_test, save_load_keyframe_index)
+{
+    const auto index_path = (std::filesystem::temp_directory_path() / test_name).replace_extension(".kfi");
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_FALSE(v->save_keyframe_index(index_path.string()));
+    ASSERT_TRUE(v->build_keyframe_index());
+    const auto keyframe_count = v->get_keyframe_count().value();
+    ASSERT_TRUE(v->save_keyframe_index(index_path.string()));
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->load_keyframe_index(index_path.string()));
+    ASSERT_EQ(v->get_keyframe_count().value(), keyframe_count);
+
+    ASSERT_TRUE(v->seek_frame(75));
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), 75.0 / fps, 0.5 / fps);
+
+    std::filesystem::remove(index_path);
+}
+
+TEST_F(video_reader_test, load_keyframe_index_with_invalid_count)
+{
+    const auto index_path = (std::filesystem::temp_directory_path() / test_name).replace_extension(".kfi");
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->build_keyframe_index());
+    ASSERT_TRUE(v->save_keyframe_index(index_path.string()));
+
+    // Entry count past the header: magic, version, stream index, time base and file size.
+    {
+        std::fstream index(index_path, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t count = uint64_t{ 1 } << 60;
+        index.seekp(32);
+        index.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_FALSE(v->load_keyframe_index(index_path.string()));
+    ASSERT_FALSE(v->get_keyframe_count().has_value());
+
+    std::filesystem::remove(index_path);
+}
+
+TEST_F(video_reader_test, load_keyframe_index_of_another_file)
+{
+    const auto index_path = (std::filesystem::temp_directory_path() / test_name).replace_extension(".kfi");
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->build_keyframe_index());
+    ASSERT_TRUE(v->save_keyframe_index(index_path.string()));
+
+    const auto other_video_path = (default_input_directory / default_video_name).replace_extension(".mkv");
+    ASSERT_TRUE(v->open(other_video_path));
+    ASSERT_FALSE(v->load_keyframe_index(index_path.string()));
+
+    std::filesystem::remove(index_path);
+}
+
+TEST_F(video_reader_test, read_batch)
+{
+    const vio::output_spec output{ vio::pixel_format::rgb24, 224, 224 };
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, output));
+
+    const int batch_size = 4;
+    const int stride = 3;
+    const auto frame_size_in_bytes = v->get_frame_size_in_bytes().value();
+    std::vector<uint8_t> batch(batch_size * frame_size_in_bytes);
+    std::array<double, batch_size> batch_pts = {};
+
+    ASSERT_EQ(v->read_batch(batch_size, stride, batch.data(), batch_pts.data()), batch_size);
+    for (int i = 1; i < batch_size; ++i)
+        ASSERT_NEAR(batch_pts[i] - batch_pts[i - 1], static_cast<double>(stride) / fps, 0.5 / fps);
+}
+
+TEST_F(video_reader_test, read_batch_until_end)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+
+    const int total_frames = 3 * fps;
+    ASSERT_TRUE(v->seek_frame(total_frames - 2));
+    std::vector<uint8_t> batch(8 * v->get_frame_size_in_bytes().value());
+    ASSERT_EQ(v->read_batch(8, 1, batch.data()), 2);
+
+    // The stream ends while skipping frames between two batch entries: frames 86 and 89 only.
+    ASSERT_TRUE(v->seek_frame(total_frames - 4));
+    ASSERT_EQ(v->read_batch(8, 3, batch.data()), 2);
+}
+
+TEST_F(video_reader_test, read_batch_invalid_parameters)
+{
+    std::vector<uint8_t> batch(frame_size);
+    ASSERT_EQ(v->read_batch(1, 1, batch.data()), 0);
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_EQ(v->read_batch(0, 1, batch.data()), 0);
+    ASSERT_EQ(v->read_batch(1, 0, batch.data()), 0);
+    ASSERT_EQ(v->read_batch(1, 1, nullptr), 0);
+
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, vio::pixel_format::native));
+    ASSERT_EQ(v->read_batch(1, 1, batch.data()), 0);
+}
+
+TEST_F(video_reader_test, read_with_frame_stride)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->set_frame_stride(10));
+
+    int num_decoded_frames = 0;
+    double previous_pts = -1.0;
+    vio::frame f;
+    while(v->read(f))
+    {
+        if(previous_pts >= 0.0)
+        {
+            ASSERT_GE(f.get_pts() - previous_pts, 10.0 / fps - 0.5 / fps);
+        }
+
+        previous_pts = f.get_pts();
+        num_decoded_frames++;
+    }
+
+    ASSERT_LE(num_decoded_frames, 3 * fps / 10);
+    ASSERT_GT(num_decoded_frames, 0);
+}
+
+TEST_F(video_reader_test, read_with_target_fps)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->set_target_fps(2.0));
+
+    int num_decoded_frames = 0;
+    uint8_t* data_buffer = nullptr;
+    while(v->read(&data_buffer))
+        num_decoded_frames++;
+
+    // 3 seconds at 2 fps
+    ASSERT_GE(num_decoded_frames, 5);
+    ASSERT_LE(num_decoded_frames, 7);
+}
+
+TEST_F(video_reader_test, set_decimation_invalid_parameters)
+{
+    ASSERT_FALSE(v->set_frame_stride(2));
+    ASSERT_FALSE(v->set_target_fps(5.0));
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_FALSE(v->set_frame_stride(0));
+    ASSERT_FALSE(v->set_target_fps(-1.0));
+    ASSERT_TRUE(v->set_frame_stride(1));
+    ASSERT_TRUE(v->set_target_fps(60.0));
+}
+
+TEST_F(video_reader_test, read_keyframes_only)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->build_keyframe_index());
+    const auto keyframe_count = v->get_keyframe_count().value();
+
+    ASSERT_TRUE(v->set_keyframes_only(true));
+
+    int num_decoded_frames = 0;
+    vio::frame f;
+    while(v->read(f))
+        num_decoded_frames++;
+
+    ASSERT_EQ(num_decoded_frames, keyframe_count);
+}
+
+TEST_F(video_reader_test, set_keyframes_only_without_open)
+{
+    ASSERT_FALSE(v->set_keyframes_only(true));
+}
+
+TEST_F(video_reader_test, set_decoder_threads)
+{
+    ASSERT_FALSE(v->get_decoder_threads().has_value());
+    ASSERT_FALSE(v->set_decoder_threads(-1));
+
+    ASSERT_TRUE(v->set_decoder_threads(2, vio::decoder_threading::slice));
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_EQ(v->get_decoder_threads().value(), 2);
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+}
+
+TEST_F(video_reader_test, decoder_thread_budget)
+{
+    vio::video_reader::set_decoder_thread_budget(3);
+    const auto threads_in_use = vio::video_reader::get_decoder_threads_in_use();
+
+    vio::video_reader other;
+    ASSERT_TRUE(v->set_decoder_threads(2));
+    ASSERT_TRUE(other.set_decoder_threads(2));
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(other.open(default_video_path));
+
+    ASSERT_EQ(v->get_decoder_threads().value(), 2);
+    ASSERT_EQ(other.get_decoder_threads().value(), 1);
+    ASSERT_EQ(vio::video_reader::get_decoder_threads_in_use(), threads_in_use + 3);
+
+    ASSERT_TRUE(other.release());
+    ASSERT_TRUE(v->release());
+    ASSERT_EQ(vio::video_reader::get_decoder_threads_in_use(), threads_in_use);
+    vio::video_reader::set_decoder_thread_budget(0);
+}
+
+TEST_F(video_reader_test, decoder_thread_budget_failed_open)
+{
+    const auto threads_in_use = vio::video_reader::get_decoder_threads_in_use();
+
+    // Fails after the decoder is opened: the output frame is too large to allocate.
+    ASSERT_TRUE(v->set_decoder_threads(2));
+    ASSERT_FALSE(v->open(default_video_path, vio::decode_support::SW, vio::output_spec{ vio::pixel_format::rgb24, 100000, 100000 }));
+    ASSERT_EQ(vio::video_reader::get_decoder_threads_in_use(), threads_in_use);
+}
+
+TEST_F(video_reader_test, frame_pool_reuses_buffers)
+{
+    ASSERT_TRUE(v->open(default_video_path));
+
+    vio::frame f;
+    for (int i = 0; i < 10; ++i)
+        ASSERT_TRUE(v->read(f));
+
+    const auto stats = v->get_frame_pool_stats().value();
+    ASSERT_GT(stats.hits, 0u);
+    ASSERT_LE(stats.misses, 3u);
+    ASSERT_EQ(stats.unpooled, 0u);
+    ASSERT_LE(stats.high_water, 3);
+}
+
+TEST_F(video_reader_test, frame_pool_size_cap)
+{
+    ASSERT_FALSE(v->set_frame_pool_size(-1));
+    ASSERT_TRUE(v->set_frame_pool_size(2));
+    ASSERT_TRUE(v->open(default_video_path));
+
+    // The reader destination frame holds one pooled buffer, the first frame the other one.
+    std::vector<vio::frame> frames(5);
+    for (auto& f : frames)
+        ASSERT_TRUE(v->read(f));
+
+    auto stats = v->get_frame_pool_stats().value();
+    ASSERT_EQ(stats.pooled_buffers, 2);
+    ASSERT_EQ(stats.outstanding, 2);
+    ASSERT_EQ(stats.unpooled, 4u);
+
+    frames.clear();
+    stats = v->get_frame_pool_stats().value();
+    ASSERT_EQ(stats.outstanding, 1);
+}
+
+TEST_F(video_reader_test, frame_outlives_reader)
+{
+    vio::frame f;
+    {
+        vio::video_reader reader;
+        ASSERT_TRUE(reader.open(default_video_path));
+        ASSERT_TRUE(reader.read(f));
+    }
+
+    ASSERT_TRUE(f.is_valid());
+    ASSERT_NE(f.get_data(), nullptr);
+}
+
+TEST_F(video_reader_test, reopen_same_stream_parameters)
+{
+    ASSERT_FALSE(v->reopen(default_video_path.string().c_str()));
+
+    const vio::output_spec output{ vio::pixel_format::rgb24, 224, 224 };
+    ASSERT_TRUE(v->open(default_video_path, vio::decode_support::SW, output));
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(v->reopen(default_video_path.string().c_str()));
+        ASSERT_TRUE(v->is_opened());
+
+        int num_decoded_frames = 0;
+        double previous_pts = -1.0;
+        vio::frame f;
+        while(v->read(f))
+        {
+            ASSERT_EQ(f.get_width(), 224);
+            ASSERT_GT(f.get_pts(), previous_pts);
+            previous_pts = f.get_pts();
+            num_decoded_frames++;
+        }
+
+        ASSERT_EQ(num_decoded_frames, 3 * fps);
+    }
+}
+
+TEST_F(video_reader_test, reopen_different_stream_parameters)
+{
+    auto other_video_path = default_video_path;
+    other_video_path.replace_extension(".mpg");
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_TRUE(v->reopen(other_video_path.string().c_str()));
+    ASSERT_TRUE(v->is_opened());
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_EQ(f.get_width(), width);
+    ASSERT_EQ(f.get_height(), height);
+}
+
+TEST_F(video_reader_test, reopen_non_existing_path)
+{
+    const auto invalid_video_path = default_input_directory / "invalid-path.mp4";
+
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_FALSE(v->reopen(invalid_video_path.string().c_str()));
+    ASSERT_FALSE(v->is_opened());
+}
+
+TEST_F(video_reader_test, open_timings)
+{
+    ASSERT_FALSE(v->get_open_timings().has_value());
+    ASSERT_TRUE(v->open(default_video_path));
+
+    const auto timings = v->get_open_timings().value();
+    ASSERT_GT(timings.total.count(), 0);
+    ASSERT_GE(timings.total, timings.open_input + timings.find_stream_info + timings.open_codec);
+}
+
+TEST_F(video_reader_test, open_with_bounded_probing)
+{
+    ASSERT_FALSE(v->set_probe_options(vio::probe_options{ 16 }));
+    ASSERT_FALSE(v->set_probe_options(vio::probe_options{ 0, std::chrono::microseconds(-1) }));
+
+    ASSERT_TRUE(v->set_probe_options(vio::probe_options{ 32 * 1024, std::chrono::milliseconds(100) }));
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_EQ(v->get_frame_count().value(), 3 * fps);
+
+    vio::frame f;
+    ASSERT_TRUE(v->read(f));
+    ASSERT_EQ(f.get_width(), width);
+}
+
+TEST_F(video_reader_test, open_trusting_container_headers)
+{
+    ASSERT_TRUE(v->set_probe_options(vio::probe_options{ 0, {}, true }));
+    ASSERT_TRUE(v->open(default_video_path));
+    ASSERT_EQ(v->get_fps().value(), fps);
+    ASSERT_EQ(v->get_open_timings().value().find_stream_info.count(), 0);
+
+    int num_decoded_frames = 0;
+    vio::frame f;
+    while(v->read(f))
+        num_decoded_frames++;
+
+    ASSERT_EQ(num_decoded_frames, 3 * fps);
+}
+
+TEST_F(video_reader_test, open_from_memory)
+{
+    std::ifstream file(default_video_path, std::ios::binary);
+    const std::vector<uint8_t> data{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    ASSERT_FALSE(data.empty());
+
+    ASSERT_TRUE(v->open(data.data(), data.size()));
+    ASSERT_EQ(v->get_frame_count().value(), 3 * fps);
+
+    int num_decoded_frames = 0;
+    vio::frame f;
+    while(v->read(f))
+        num_decoded_frames++;
+
+    ASSERT_EQ(num_decoded_frames, 3 * fps);
+
+    ASSERT_TRUE(v->seek_frame(30));
+    ASSERT_TRUE(v->read(f));
+    ASSERT_NEAR(f.get_pts(), 1.0, 0.5 / fps);
+}
+
+TEST_F(video_reader_test, open_from_non_seekable_callbacks)
+{
+    auto stream_path = default_video_path;
+    stream_path.replace_extension(".mpg");
+    std::ifstream file(stream_path, std::ios::binary);
+
+    vio::input_callbacks input;
+    input.read = [&file](uint8_t* buffer, int size)
+    {
+        file.read(reinterpret_cast<char*>(buffer), size);
+        return static_cast<int>(file.gcount());
+    };
+
+    ASSERT_TRUE(v->open(input));
+
+    int num_decoded_frames = 0;
+    vio::frame f;
+    while(v->read(f))
+        num_decoded_frames++;
+
+    ASSERT_EQ(num_decoded_frames, 3 * fps);
+}
+
+TEST_F(video_reader_test, open_mapped)
+{
+    ASSERT_TRUE(v->open_mapped(default_video_path.string().c_str()));
+    ASSERT_TRUE(v->is_opened());
+
+    int num_decoded_frames = 0;
+    vio::frame f;
+    while(v->read(f))
+        num_decoded_frames++;
+
+    ASSERT_EQ(num_decoded_frames, 3 * fps);
+
+    // Reopening releases the previous mapping
+    ASSERT_TRUE(v->open_mapped(default_video_path.string().c_str()));
+    ASSERT_TRUE(v->read(f));
+}
+
+TEST_F(video_reader_test, open_mapped_non_existing_path)
+{
+    const auto invalid_video_path = default_input_directory / "invalid-path.mp4";
+    ASSERT_FALSE(v->open_mapped(invalid_video_path.string().c_str()));
+    ASSERT_FALSE(v->is_opened());
+}
+
+TEST_F(video_reader_test, open_invalid_custom_input)
+{
+    const uint8_t data[16] = {};
+    ASSERT_FALSE(v->open(vio::input_callbacks{}));
+    ASSERT_FALSE(v->open(data, 0));
+    ASSERT_FALSE(v->open(nullptr, 16));
+    ASSERT_FALSE(v->open(data, sizeof(data)));
+    ASSERT_FALSE(v->is_opened());
+}
+
 TEST_P(video_reader_test, read_n_frames)
 {
     const std::string video_extension = GetParam();
@@ -0,0 +1,104 @@
+#include "test_video_trim.hpp"
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace vio::test
+{
+using namespace std::chrono_literals;
+
+TEST_F(video_trim_test, remux_to_other_container)
+{
+    const auto output_path = (default_output_directory / test_name).replace_extension(".mkv").string();
+    ASSERT_TRUE(vio::remux(default_video_path, output_path));
+
+    // Every frame is copied.
+    ASSERT_EQ(read_frames(output_path), duration * fps);
+}
+
+TEST_F(video_trim_test, trim_keyframe_aligned)
+{
+    ASSERT_TRUE(write_short_gop_video(short_gop_video_path));
+    const auto input_frames = read_rgb_frames(short_gop_video_path);
+    ASSERT_EQ(input_frames.size(), static_cast<size_t>(duration * fps));
+
+    // Frames [15, 45) with a keyframe every 10 frames: extended to [10, 50), the keyframe before start
+    // up to right before the first keyframe at or after end. Copied packets decode to the very same frames.
+    ASSERT_TRUE(vio::trim(short_gop_video_path, default_output_path, 500ms, 1500ms));
+    auto frames = read_rgb_frames(default_output_path);
+    ASSERT_EQ(frames.size(), static_cast<size_t>(4 * short_gop_size));
+    ASSERT_NEAR(frames.front().get_pts(), 0.0, 0.5 / fps);
+    ASSERT_TRUE(is_same_frame(frames.front(), input_frames[10]));
+    ASSERT_TRUE(is_same_frame(frames.back(), input_frames[49]));
+
+    // Cuts on keyframes are not extended.
+    ASSERT_TRUE(vio::trim(short_gop_video_path, default_output_path, 1s, 2s));
+    frames = read_rgb_frames(default_output_path);
+    ASSERT_EQ(frames.size(), static_cast<size_t>(fps));
+    ASSERT_TRUE(is_same_frame(frames.front(), input_frames[30]));
+    ASSERT_TRUE(is_same_frame(frames.back(), input_frames[59]));
+}
+
+TEST_F(video_trim_test, trim_whole_video)
+{
+    ASSERT_TRUE(vio::trim(default_video_path, default_output_path, 0s, 10s));
+    ASSERT_EQ(read_frames(default_output_path), duration * fps);
+}
+
+TEST_F(video_trim_test, smart_trim_frame_accurate)
+{
+    ASSERT_TRUE(vio::trim(default_video_path, default_output_path, 500ms, 1500ms, vio::trim_mode::smart));
+
+    double first_pts = -1.0;
+    double last_pts = -1.0;
+    const int num_frames = read_frames(default_output_path, &first_pts, &last_pts);
+
+    // Exactly the frames in [start, end), whatever the keyframe positions.
+    ASSERT_NEAR(num_frames, fps, 1);
+    ASSERT_NEAR(first_pts, 0.0, 1.0 / fps);
+    ASSERT_NEAR(last_pts - first_pts, 1.0 - 1.0 / fps, 1.0 / fps);
+}
+
+TEST_F(video_trim_test, smart_trim_across_keyframes)
+{
+    ASSERT_TRUE(write_short_gop_video(short_gop_video_path));
+    const auto input_frames = read_rgb_frames(short_gop_video_path);
+    ASSERT_EQ(input_frames.size(), static_cast<size_t>(duration * fps));
+
+    // Frames [15, 45) with a keyframe every 10 frames: head [15, 20) re-encoded, [20, 40) copied across the keyframes
+    // at 20 and 30, tail [40, 45) re-encoded. The muxer rejects the cut if dts does not increase across the splice points.
+    ASSERT_TRUE(vio::trim(short_gop_video_path, default_output_path, 500ms, 1500ms, vio::trim_mode::smart));
+
+    // A decoding error (e.g. avcodec_send_packet failing on the spliced parameter sets) ends the read early.
+    const auto frames = read_rgb_frames(default_output_path);
+    ASSERT_EQ(frames.size(), static_cast<size_t>(fps));
+    ASSERT_NEAR(frames.front().get_pts(), 0.0, 0.5 / fps);
+    for (size_t i = 1; i < frames.size(); ++i)
+        ASSERT_GT(frames[i].get_pts(), frames[i - 1].get_pts());
+
+    // The copied GOPs decode exactly as in the input: their parameter sets are restored after the re-encoded head.
+    for (int i = 5; i < 25; ++i)
+        ASSERT_TRUE(is_same_frame(frames[i], input_frames[15 + i])) << "frame " << i;
+}
+
+TEST_F(video_trim_test, smart_trim_within_one_gop)
+{
+    ASSERT_TRUE(vio::trim(default_video_path, default_output_path, 100ms, 300ms, vio::trim_mode::smart));
+    ASSERT_NEAR(read_frames(default_output_path), fps / 5, 1);
+}
+
+TEST_F(video_trim_test, trim_invalid_range)
+{
+    ASSERT_FALSE(vio::trim(default_video_path, default_output_path, 2s, 1s));
+    ASSERT_FALSE(vio::trim(default_video_path, default_output_path, -1s, 1s));
+    ASSERT_FALSE(vio::trim(default_video_path, default_output_path, 1s, 1s, vio::trim_mode::smart));
+}
+
+TEST_F(video_trim_test, trim_non_existing_path)
+{
+    const auto invalid_video_path = (default_input_directory / "invalid-path.mp4").string();
+    ASSERT_FALSE(vio::remux(invalid_video_path, default_output_path));
+    ASSERT_FALSE(vio::trim(invalid_video_path, default_output_path, 0s, 1s));
+}
+
+}
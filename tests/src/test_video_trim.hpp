@@ -0,0 +1,137 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+#include <video_io/video_trim.hpp>
+#include <video_io/video_reader.hpp>
+#include <video_io/video_writer.hpp>
+
+#include <filesystem>
+#include <vector>
+#include <algorithm>
+
+namespace vio::test
+{
+
+class video_trim_test : public ::testing::Test
+{
+protected:
+    explicit video_trim_test()
+    : test_name { testing::UnitTest::GetInstance()->current_test_info()->name() }
+    , default_input_directory{ std::filesystem::current_path() / "../../../tests/data/new" }
+    , default_output_directory{ std::filesystem::current_path() / "temp" }
+    , default_video_extension { ".mp4" }
+    , default_video_name { "testsrc2_3sec_30fps_640x480" }
+    , default_video_path { (default_input_directory / default_video_name).replace_extension(default_video_extension).string() }
+    , default_output_path { (default_output_directory / test_name).replace_extension(default_video_extension).string() }
+    , short_gop_video_path { (default_output_directory / (test_name + "_short_gop")).replace_extension(default_video_extension).string() }
+    { }
+
+    virtual ~video_trim_test() { }
+
+    virtual void SetUp() override 
+    {
+        std::filesystem::create_directories(default_output_directory);
+    }
+
+    virtual void TearDown() override { }
+
+    // Decoded frame count and pts of the first and last frames, in seconds.
+    static int read_frames(const std::string& video_path, double* first_pts = nullptr, double* last_pts = nullptr)
+    {
+        vio::video_reader reader;
+        if (!reader.open(video_path.c_str()))
+            return -1;
+
+        int num_frames = 0;
+        vio::frame f;
+        while (reader.read(f))
+        {
+            if (num_frames == 0 && first_pts)
+                *first_pts = f.get_pts();
+
+            if (last_pts)
+                *last_pts = f.get_pts();
+
+            num_frames++;
+        }
+
+        return num_frames;
+    }
+
+    // H.264 with B-frames and a keyframe every short_gop_size frames: cuts span several GOPs.
+    // The test asset has a single keyframe.
+    static bool write_short_gop_video(const std::string& video_path)
+    {
+        vio::encoder_spec encoder{ "libx264" };
+        encoder.gop_size = short_gop_size;
+        encoder.max_b_frames = 2;
+        encoder.options = { { "x264-params", "scenecut=0" } };
+
+        vio::video_writer writer;
+        if (!writer.set_encoder(encoder) || !writer.open(video_path, short_gop_width, short_gop_height, fps))
+            return false;
+
+        // Moving pattern: consecutive frames differ, so that B-frames are actually used.
+        std::vector<uint8_t> frame_data(short_gop_width * short_gop_height * 3 / 2);
+        for (int i = 0; i < duration * fps; ++i)
+        {
+            for (size_t j = 0; j < frame_data.size(); ++j)
+                frame_data[j] = static_cast<uint8_t>(j % short_gop_width + 4 * i);
+
+            if (!writer.write(frame_data.data()))
+                return false;
+        }
+
+        return writer.save();
+    }
+
+    // Every decoded frame in RGB, so that frames of different files can be compared.
+    static std::vector<vio::frame> read_rgb_frames(const std::string& video_path)
+    {
+        std::vector<vio::frame> frames;
+        vio::video_reader reader;
+        if (!reader.open(video_path.c_str(), vio::decode_support::SW, vio::output_spec{ vio::pixel_format::rgb24 }))
+            return frames;
+
+        vio::frame f;
+        while (reader.read(f))
+            frames.push_back(f);
+
+        return frames;
+    }
+
+    static bool is_same_frame(const vio::frame& a, const vio::frame& b)
+    {
+        if (a.get_width() != b.get_width() || a.get_height() != b.get_height())
+            return false;
+
+        const int row_size = a.get_width() * 3;
+        for (int y = 0; y < a.get_height(); ++y)
+        {
+            const uint8_t* row_a = a.get_data() + y * a.get_linesize();
+            const uint8_t* row_b = b.get_data() + y * b.get_linesize();
+            if (!std::equal(row_a, row_a + row_size, row_b))
+                return false;
+        }
+
+        return true;
+    }
+
+    const std::string test_name;
+    const std::filesystem::path default_input_directory;
+    const std::filesystem::path default_output_directory;
+    const std::string default_video_extension;
+    const std::string default_video_name;
+    const std::string default_video_path;
+    const std::string default_output_path;
+    const std::string short_gop_video_path;
+
+    static const int fps = 30;
+    static const int duration = 3;
+
+    static const int short_gop_size = 10;
+    static const int short_gop_width = 320;
+    static const int short_gop_height = 240;
+};
+
+}
@@ -1,5 +1,6 @@
 #include "test_video_writer.hpp"
 #include "video_io/video_writer.hpp"
+#include "video_io/video_reader.hpp"
 #include <filesystem>
 #include <thread>
 
@@ -274,6 +275,283 @@ TEST_P(video_writer_test, write_parallel)
     }
 }
 
+TEST_F(video_writer_test, write_with_encoder_spec)
+{
+    vio::encoder_spec encoder{ "mpeg4" };
+    encoder.bit_rate = 2000000;
+    encoder.gop_size = fps;
+    encoder.max_b_frames = 0;
+    encoder.threads = 2;
+    encoder.options["unknown-option"] = "1";
+    ASSERT_TRUE(v->set_encoder(encoder));
+
+    ASSERT_TRUE(v->open(default_video_path, width, height, fps));
+    for (int i = 0; i < fps; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    ASSERT_TRUE(v->save());
+}
+
+TEST_F(video_writer_test, open_invalid_encoder)
+{
+    vio::encoder_spec invalid_gop;
+    invalid_gop.gop_size = -1;
+    ASSERT_FALSE(v->set_encoder(invalid_gop));
+
+    ASSERT_TRUE(v->set_encoder(vio::encoder_spec{ "invalid-encoder" }));
+    ASSERT_FALSE(v->open(default_video_path, width, height, fps));
+
+    // Audio encoders are rejected
+    ASSERT_TRUE(v->set_encoder(vio::encoder_spec{ "aac" }));
+    ASSERT_FALSE(v->open(default_video_path, width, height, fps));
+}
+
+TEST_F(video_writer_test, write_bgr_round_trip)
+{
+    ASSERT_TRUE(v->set_input(vio::input_spec{ vio::pixel_format::bgr24 }));
+
+    std::vector<uint8_t> bgr_frame(width * height * 3);
+    for (size_t i = 0; i < bgr_frame.size(); i += 3)
+    {
+        bgr_frame[i] = 200;
+        bgr_frame[i + 1] = 100;
+        bgr_frame[i + 2] = 50;
+    }
+
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+    for (int i = 0; i < fps; ++i)
+        ASSERT_TRUE(v->write(bgr_frame.data()));
+
+    ASSERT_TRUE(v->save());
+
+    vio::video_reader reader;
+    ASSERT_TRUE(reader.open(buffer.data(), buffer.size(), vio::decode_support::SW, vio::pixel_format::bgr24));
+
+    uint8_t* data = nullptr;
+    ASSERT_TRUE(reader.read(&data));
+    const auto center = (height / 2 * width + width / 2) * 3;
+    ASSERT_NEAR(data[center], 200, 8);
+    ASSERT_NEAR(data[center + 1], 100, 8);
+    ASSERT_NEAR(data[center + 2], 50, 8);
+}
+
+TEST_F(video_writer_test, write_resized_rgba_input)
+{
+    const int input_width = width / 2;
+    const int input_height = height / 2;
+    ASSERT_TRUE(v->set_input(vio::input_spec{ vio::pixel_format::rgba, input_width, input_height, vio::scale_algorithm::bilinear }));
+
+    std::vector<uint8_t> rgba_frame(input_width * input_height * 4, 128);
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+    for (int i = 0; i < fps; ++i)
+        ASSERT_TRUE(v->write(rgba_frame.data()));
+
+    ASSERT_TRUE(v->save());
+
+    vio::video_reader reader;
+    ASSERT_TRUE(reader.open(buffer.data(), buffer.size()));
+    const auto [frame_width, frame_height] = reader.get_frame_size().value();
+    ASSERT_EQ(frame_width, width);
+    ASSERT_EQ(frame_height, height);
+}
+
+TEST_F(video_writer_test, write_in_place_without_encoder_delay)
+{
+    vio::encoder_spec encoder{ "mpeg4" };
+    encoder.max_b_frames = 0;
+    encoder.threads = 1;
+    ASSERT_TRUE(v->set_encoder(encoder));
+
+    std::vector<uint8_t> yuv_frame(width * height * 3 / 2, 64);
+    ASSERT_TRUE(v->open(default_video_path, width, height, fps));
+    for (int i = 0; i < fps; ++i)
+        ASSERT_TRUE(v->write(yuv_frame.data()));
+
+    ASSERT_TRUE(v->save());
+}
+
+TEST_F(video_writer_test, set_invalid_input)
+{
+    ASSERT_FALSE(v->set_input(vio::input_spec{ vio::pixel_format::rgb24, -1, 240 }));
+}
+
+TEST_F(video_writer_test, write_variable_frame_rate)
+{
+    // Millisecond timestamps with jitter and a few missing frames.
+    const std::vector<int64_t> timestamps = { 0, 31, 68, 100, 133, 170, 200, 300, 333, 366, 405, 433, 466, 500 };
+
+    ASSERT_TRUE(v->set_time_base(1, 1000));
+
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+    for (const auto pts : timestamps)
+        ASSERT_TRUE(v->write(frame_data.data(), pts));
+
+    ASSERT_TRUE(v->save());
+
+    vio::video_reader reader;
+    ASSERT_TRUE(reader.open(buffer.data(), buffer.size()));
+
+    std::vector<double> read_timestamps;
+    vio::frame f;
+    while(reader.read(f))
+        read_timestamps.push_back(f.get_pts());
+
+    // Only the written frames are encoded, each at its own time.
+    ASSERT_EQ(read_timestamps.size(), timestamps.size());
+    for (size_t i = 0; i < timestamps.size(); ++i)
+        ASSERT_NEAR(read_timestamps[i] - read_timestamps[0], timestamps[i] / 1000.0, 0.002);
+}
+
+TEST_F(video_writer_test, write_non_increasing_pts)
+{
+    ASSERT_TRUE(v->open(default_video_path, width, height, fps));
+    ASSERT_TRUE(v->write(frame_data.data(), 10));
+    ASSERT_FALSE(v->write(frame_data.data(), 10));
+    ASSERT_FALSE(v->write(frame_data.data(), 5));
+
+    // Constant frame rate writes continue from the last pts.
+    ASSERT_TRUE(v->write(frame_data.data()));
+    ASSERT_TRUE(v->write(frame_data.data(), 12));
+    ASSERT_TRUE(v->save());
+}
+
+TEST_F(video_writer_test, set_invalid_time_base)
+{
+    ASSERT_FALSE(v->set_time_base(0, 1000));
+    ASSERT_FALSE(v->set_time_base(1, -1000));
+    ASSERT_TRUE(v->set_time_base(1, 90000));
+    ASSERT_TRUE(v->set_time_base(0, 0));
+}
+
+TEST_F(video_writer_test, write_segments)
+{
+    std::filesystem::create_directories(default_output_directory);
+    const auto pattern = (default_output_directory / (test_name + "_%03d.mp4")).string();
+
+    std::vector<std::string> segment_paths;
+    vio::segment_spec segments{ pattern, std::chrono::seconds(1) };
+    segments.on_segment = [&segment_paths](const std::string& path) { segment_paths.push_back(path); };
+
+    ASSERT_TRUE(v->open(segments, width, height, fps));
+
+    const int num_frames_to_write = 3 * fps + fps / 2;
+    for (int i = 0; i < num_frames_to_write; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    ASSERT_TRUE(v->save());
+    ASSERT_EQ(segment_paths.size(), 4u);
+
+    // Every segment plays on its own and starts at 0, no frame is lost across the boundaries.
+    int num_read_frames = 0;
+    for (size_t i = 0; i < segment_paths.size(); ++i)
+    {
+        vio::video_reader reader;
+        ASSERT_TRUE(reader.open(segment_paths[i].c_str()));
+
+        int num_segment_frames = 0;
+        vio::frame f;
+        while(reader.read(f))
+        {
+            if (num_segment_frames == 0)
+            {
+                ASSERT_NEAR(f.get_pts(), 0.0, 1.0 / fps);
+            }
+
+            num_segment_frames++;
+        }
+
+        if (i + 1 < segment_paths.size())
+        {
+            ASSERT_EQ(num_segment_frames, fps);
+        }
+
+        num_read_frames += num_segment_frames;
+    }
+
+    ASSERT_EQ(num_read_frames, num_frames_to_write);
+}
+
+TEST_F(video_writer_test, write_mpegts_segments)
+{
+    std::filesystem::create_directories(default_output_directory);
+    const auto pattern = (default_output_directory / (test_name + "_%d.ts")).string();
+
+    int num_segments = 0;
+    vio::segment_spec segments{ pattern, std::chrono::milliseconds(500), false };
+    segments.on_segment = [&num_segments](const std::string&) { num_segments++; };
+
+    ASSERT_TRUE(v->open(segments, width, height, fps));
+    for (int i = 0; i < 2 * fps; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    ASSERT_TRUE(v->save());
+    ASSERT_EQ(num_segments, 4);
+}
+
+TEST_F(video_writer_test, open_invalid_segments)
+{
+    const auto pattern = (default_output_directory / (test_name + "_%03d.mp4")).string();
+    ASSERT_FALSE(v->open(vio::segment_spec{}, width, height, fps));
+    ASSERT_FALSE(v->open(vio::segment_spec{ pattern, std::chrono::milliseconds(0) }, width, height, fps));
+    ASSERT_FALSE(v->open(vio::segment_spec{ (default_output_directory / "no_number.mp4").string() }, width, height, fps));
+}
+
+TEST_F(video_writer_test, write_to_memory_sink)
+{
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(v->open(vio::memory_sink(buffer, "mp4"), width, height, fps));
+
+    const int num_frames_to_write = fps;
+    for (int i = 0; i < num_frames_to_write; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    ASSERT_TRUE(v->save());
+    ASSERT_FALSE(buffer.empty());
+
+    vio::video_reader reader;
+    ASSERT_TRUE(reader.open(buffer.data(), buffer.size()));
+
+    int num_read_frames = 0;
+    uint8_t* data = nullptr;
+    while(reader.read(&data))
+        num_read_frames++;
+
+    ASSERT_EQ(num_read_frames, num_frames_to_write);
+}
+
+TEST_F(video_writer_test, write_fragmented_mp4_to_callback_sink)
+{
+    size_t num_bytes_written = 0;
+    vio::output_sink sink{ "mp4", 4096, true };
+    sink.write = [&num_bytes_written](const uint8_t*, int size)
+    {
+        num_bytes_written += size;
+        return size;
+    };
+
+    ASSERT_TRUE(v->open(sink, width, height, fps));
+    for (int i = 0; i < 2 * fps; ++i)
+        ASSERT_TRUE(v->write(frame_data.data()));
+
+    // Fragments reach the sink while encoding, before the writer is saved.
+    ASSERT_GT(num_bytes_written, 0u);
+
+    ASSERT_TRUE(v->save());
+    ASSERT_FALSE(v->is_opened());
+}
+
+TEST_F(video_writer_test, open_invalid_sink)
+{
+    ASSERT_FALSE(v->open(vio::output_sink{}, width, height, fps));
+
+    vio::output_sink sink{ "invalid-format" };
+    sink.write = [](const uint8_t*, int size){ return size; };
+    ASSERT_FALSE(v->open(sink, width, height, fps));
+}
+
 INSTANTIATE_TEST_SUITE_P(multi_format, video_writer_test, ::testing::Values(".mp4", ".mpeg", ".avi"));
 
 /* 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "api.hpp"
+#include "frame.hpp"
+#include "video_reader.hpp"
+
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <mutex>
+
+namespace vio
+{
+/**
+ * video_reader running demux, decode and color conversion on three background threads,
+ * connected by bounded queues of queue_depth elements, so that the three stages overlap.
+*/
+class API_VIDEO_IO async_video_reader
+{
+public:
+    explicit async_video_reader(size_t queue_depth = 8) noexcept;
+    ~async_video_reader() noexcept;
+
+    bool open(const char* video_path, decode_support decode_preference = decode_support::none, const output_spec& output = {});
+    bool is_opened() const;
+    bool read(frame& f);
+    bool try_read(frame& f);
+    bool set_decoder_threads(int count, decoder_threading model = decoder_threading::automatic);
+    bool release();
+
+    auto get_frame_count() const -> std::optional<int>;
+    auto get_duration() const -> std::optional<std::chrono::steady_clock::duration>;
+    auto get_frame_size() const -> std::optional<std::tuple<int, int>>;
+    auto get_frame_size_in_bytes() const -> std::optional<int>;
+    auto get_fps() const -> std::optional<double>;
+
+protected:
+    void demux_thread();
+    void decode_thread();
+    void convert_thread();
+
+private:
+    bool _is_opened;
+    std::mutex _open_mutex;
+    size_t _queue_depth;
+
+    std::unique_ptr<video_reader> _reader;
+
+    struct pipeline;
+    std::unique_ptr<pipeline> _pipeline;
+};
+
+}
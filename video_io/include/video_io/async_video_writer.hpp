@@ -0,0 +1,70 @@
+#pragma once
+
+#include "api.hpp"
+#include "video_writer.hpp"
+
+#include <memory>
+#include <string>
+#include <future>
+#include <mutex>
+#include <atomic>
+
+namespace vio
+{
+/**
+ * What write() does when the input queue is full.
+ * block: wait for room. drop_oldest: the oldest pending frame makes room for the new one. drop_newest: the new frame is discarded.
+*/
+enum class backpressure_policy { block, drop_oldest, drop_newest };
+
+/**
+ * video_writer running color conversion, encode and mux/IO on three background threads,
+ * connected by bounded queues of queue_depth elements: write() copies the frame into the input queue and returns.
+ * Dropped frames are never encoded, timestamps stay contiguous and the output is just shorter.
+*/
+class API_VIDEO_IO async_video_writer
+{
+public:
+    explicit async_video_writer(size_t queue_depth = 8, backpressure_policy policy = backpressure_policy::block) noexcept;
+    ~async_video_writer() noexcept;
+
+    bool open(const std::string& video_path, int width, int height, int fps);
+    bool open(const output_sink& sink, int width, int height, int fps);
+    // Take effect at the next open.
+    bool set_input(const input_spec& input);
+    bool set_encoder(const encoder_spec& encoder);
+    bool is_opened() const;
+    // Returns false when the frame is not queued: writer not opened, pipeline failure or dropped by drop_newest.
+    bool write(const uint8_t* data);
+    // Ready once every frame written before the call is encoded and its packets are pushed to the output.
+    // Frames held back by the encoder (B-frames, lookahead) are only emitted by save.
+    std::future<bool> flush();
+    // Waits for the queued frames, then writes the trailer.
+    bool save();
+    // Pending frames are discarded.
+    bool release();
+
+    auto get_dropped_frames() const -> uint64_t;
+
+protected:
+    bool start();
+    bool stop();
+    void convert_thread();
+    void encode_thread();
+    void mux_thread();
+
+private:
+    bool _is_opened;
+    std::mutex _open_mutex;
+    size_t _queue_depth;
+    backpressure_policy _policy;
+    size_t _frame_size;
+    std::atomic<uint64_t> _dropped_frames;
+
+    std::unique_ptr<video_writer> _writer;
+
+    struct pipeline;
+    std::unique_ptr<pipeline> _pipeline;
+};
+
+}
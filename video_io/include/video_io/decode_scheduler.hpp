@@ -0,0 +1,79 @@
+#pragma once
+
+#include "api.hpp"
+#include "frame.hpp"
+#include "video_reader.hpp"
+
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <map>
+
+namespace vio
+{
+/**
+ * Higher priority streams are always served first by idle workers (e.g. live feeds over batch jobs).
+*/
+enum class stream_priority { low, normal, high };
+
+/**
+ * Decodes many streams on a fixed pool of worker threads instead of one set of codec threads per reader.
+ * Each stream uses a single threaded decoder and conversion: parallelism comes from decoding streams concurrently.
+ * A task decodes and converts one frame of one stream, then the stream goes back at the end of the queue so that
+ * streams of the same priority take turns. Idle workers steal tasks from busy ones.
+ * A stream is only scheduled while its output queue (queue_depth frames) has room.
+*/
+class API_VIDEO_IO decode_scheduler
+{
+public:
+    // worker_count == 0: one worker per core.
+    explicit decode_scheduler(size_t worker_count = 0, size_t queue_depth = 4) noexcept;
+    ~decode_scheduler() noexcept;
+
+    auto add_stream(const char* video_path, decode_support decode_preference = decode_support::none, const output_spec& output = {},
+        stream_priority priority = stream_priority::normal) -> std::optional<int>;
+    bool remove_stream(int stream_id);
+    bool set_priority(int stream_id, stream_priority priority);
+    bool read(int stream_id, frame& f);
+    bool try_read(int stream_id, frame& f);
+    bool release();
+
+    auto get_worker_count() const -> size_t;
+    auto get_stream_count() const -> size_t;
+    auto get_frame_size(int stream_id) const -> std::optional<std::tuple<int, int>>;
+    auto get_fps(int stream_id) const -> std::optional<double>;
+
+protected:
+    struct stream;
+    struct worker_queue;
+
+    void worker_thread(size_t worker_index);
+    void run(const std::shared_ptr<stream>& s, size_t worker_index);
+    void schedule(const std::shared_ptr<stream>& s, size_t worker_index);
+    void reschedule(const std::shared_ptr<stream>& s);
+    bool pop(size_t worker_index, std::shared_ptr<stream>* s);
+    auto find_stream(int stream_id) const -> std::shared_ptr<stream>;
+
+private:
+    size_t _queue_depth;
+    std::atomic<bool> _is_running;
+
+    mutable std::mutex _streams_mutex;
+    std::map<int, std::shared_ptr<stream>> _streams;
+    int _next_stream_id;
+
+    std::vector<std::unique_ptr<worker_queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<size_t> _next_worker;
+
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::atomic<size_t> _pending_tasks;
+    bool _stopping;
+};
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "api.hpp"
+
+#include <cstdint>
+
+struct AVFrame;
+
+namespace vio
+{
+class video_reader;
+
+/**
+ * Pixel layout of the frames returned by video_reader.
+ * native: decoded frames are returned as produced by the codec (e.g. YUV420P, NV12), without any color conversion.
+*/
+enum class pixel_format { bgr24, rgb24, rgba, gray8, nv12, yuv420p, native };
+
+/**
+ * Interpolation used by the scaler when the output resolution differs from the source one.
+*/
+enum class scale_algorithm { fast_bilinear, bilinear, bicubic, area };
+
+/**
+ * Refcounted handle to a decoded video frame.
+ * Copies share the same underlying AVFrame buffers (no pixel data is copied),
+ * so a frame can be kept alive and moved across threads after video_reader::read returns.
+*/
+class API_VIDEO_IO frame
+{
+public:
+    explicit frame() noexcept;
+    ~frame() noexcept;
+
+    frame(const frame& other) noexcept;
+    frame& operator=(const frame& other) noexcept;
+    frame(frame&& other) noexcept;
+    frame& operator=(frame&& other) noexcept;
+
+    bool is_valid() const;
+    void reset();
+
+    auto get_data(int plane = 0) const -> const uint8_t*;
+    auto get_linesize(int plane = 0) const -> int;
+    auto get_width() const -> int;
+    auto get_height() const -> int;
+    auto get_format() const -> int;
+    auto get_pts() const -> double;
+
+protected:
+    friend class video_reader;
+    bool ref(const AVFrame* src, double pts);
+
+private:
+    AVFrame* _frame;
+    double _pts;
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "api.hpp"
+#include "frame.hpp"
 
 #include <string>
 #include <functional>
@@ -17,6 +18,7 @@ struct AVFrame;
 struct SwsContext;
 struct AVDictionary;
 struct AVInputFormat;
+struct AVCodecParameters;
 
 namespace vio
 {
@@ -24,6 +26,90 @@ struct simple_frame;
 enum class decode_support { none, SW, HW };
 struct screen_options{};
 
+/**
+ * keyframe: jump to the closest keyframe at or before the requested position (fast, not frame accurate).
+ * precise: decode forward from that keyframe and stop at the first frame at or after the requested position.
+*/
+enum class seek_mode { keyframe, precise };
+
+/**
+ * frame: one frame per thread, best throughput but adds thread_count frames of latency.
+ * slice: threads share the slices of a single frame, no extra latency (live streams), if the codec supports it.
+ * automatic: let the codec pick among the models it supports.
+*/
+enum class decoder_threading { automatic, frame, slice };
+
+/**
+ * Output frames layout: decode, scale and color conversion happen in a single sws_scale pass.
+ * A width or height of 0 keeps the source size along that axis. Size and scaler are ignored for pixel_format::native.
+ * conversion_threads: number of slices converted in parallel, independent of decoder threads (0: one per core).
+*/
+struct output_spec
+{
+    output_spec(pixel_format format = pixel_format::bgr24, int width = 0, int height = 0, scale_algorithm scaler = scale_algorithm::bicubic, int conversion_threads = 1)
+    : format{ format }, width{ width }, height{ height }, scaler{ scaler }, conversion_threads{ conversion_threads } { }
+
+    pixel_format format;
+    int width;
+    int height;
+    scale_algorithm scaler;
+    int conversion_threads;
+};
+
+/**
+ * Destination frame buffers reuse: hits are buffers taken back from the pool, misses new allocations kept in the pool.
+ * Once a size has max buffers all in use, further buffers are unpooled: allocated and freed as usual.
+*/
+struct frame_pool_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t unpooled;
+    int outstanding;
+    int high_water;
+    int pooled_buffers;
+};
+
+/**
+ * Bounds the stream probing done at open (0: FFmpeg defaults, 5 MB and 5 s).
+ * trust_container_headers: skip avformat_find_stream_info when the container headers already give the video codec,
+ * size and frame rate. Formats without headers (e.g. MPEG-TS) are still probed. When the pixel format is only in
+ * the bitstream (e.g. H.264 or HEVC in MP4), the first frame is decoded at open to get it.
+*/
+struct probe_options
+{
+    probe_options(int64_t probesize = 0, std::chrono::microseconds analyze_duration = {}, bool trust_container_headers = false)
+    : probesize{ probesize }, analyze_duration{ analyze_duration }, trust_container_headers{ trust_container_headers } { }
+
+    int64_t probesize;
+    std::chrono::microseconds analyze_duration;
+    bool trust_container_headers;
+};
+
+/**
+ * Time spent in each phase of the last open: demuxer open, stream probing and decoder open.
+*/
+struct open_timings
+{
+    std::chrono::microseconds open_input;
+    std::chrono::microseconds find_stream_info;
+    std::chrono::microseconds open_codec;
+    std::chrono::microseconds total;
+};
+
+/**
+ * Input read through user callbacks instead of a path, e.g. straight from memory or a network client.
+ * read: fill up to size bytes, return the number of bytes read, 0 at end of stream, < 0 on error.
+ * seek: fseek-like (SEEK_SET, SEEK_CUR, SEEK_END), return the new position or < 0 on error. Leave empty for non seekable inputs.
+ * size: total size in bytes, < 0 if unknown. Optional.
+*/
+struct input_callbacks
+{
+    std::function<int(uint8_t* buffer, int size)> read;
+    std::function<int64_t(int64_t offset, int whence)> seek;
+    std::function<int64_t()> size;
+};
+
 class API_VIDEO_IO video_reader
 {
 public:
@@ -33,29 +119,88 @@ public:
     using log_callback_t = std::function<void(const std::string&)>;
     // void set_log_callback(const log_callback_t& cb, const log_level& level = log_level::all);
 
-    bool open(const char* video_path, decode_support decode_preference = decode_support::none);
+    bool open(const char* video_path, decode_support decode_preference = decode_support::none, const output_spec& output = {});
     bool open(const char* screen_name, screen_options screen_opt);
+    bool open(const input_callbacks& input, decode_support decode_preference = decode_support::none, const output_spec& output = {});
+    // Decode from memory: data must stay valid until release.
+    bool open(const uint8_t* data, size_t size, decode_support decode_preference = decode_support::none, const output_spec& output = {});
+    // Local files only: the file is memory mapped and read without read() syscalls.
+    bool open_mapped(const char* video_path, decode_support decode_preference = decode_support::none, const output_spec& output = {});
+    // Open another file with the same decode preference and output. When its video stream has the same parameters,
+    // only the demuxer is reopened: decoder, scaler and frame buffers are kept. Otherwise falls back to a full open.
+    bool reopen(const char* video_path);
     bool is_opened() const;
     bool read(uint8_t** data, double* pts = nullptr);
+    bool read(frame& f);
+    // Decode n frames, one every stride, into buffer (n * get_frame_size_in_bytes() bytes, NHWC for packed formats).
+    // Returns the number of frames written; pts (optional) must hold n values.
+    int read_batch(int n, int stride, uint8_t* buffer, double* pts = nullptr);
+    // position is on the same timeline as the frame pts: stream timestamps, not offset by the stream start time.
+    bool seek(std::chrono::steady_clock::duration position, seek_mode mode = seek_mode::precise);
+    // frame_index counts frames from the first one, whatever the stream start time.
+    bool seek_frame(int frame_index, seek_mode mode = seek_mode::precise);
+    bool set_frame_stride(int stride);
+    bool set_target_fps(double fps);
+    bool set_keyframes_only(bool enable);
+    bool build_keyframe_index();
+    bool save_keyframe_index(const std::string& index_path) const;
+    bool load_keyframe_index(const std::string& index_path);
+    // Takes effect at the next open. count == 0: one thread per core, bounded by the decoder thread budget.
+    bool set_decoder_threads(int count, decoder_threading model = decoder_threading::automatic);
+    // Takes effect at the next open.
+    bool set_probe_options(const probe_options& options);
+    // Maximum number of pooled buffers per frame size (0: unlimited). The pool is kept across open and release.
+    bool set_frame_pool_size(int max_buffers);
     bool release();
+
+    // Process-wide number of decoder threads shared by all readers (0: unlimited).
+    static void set_decoder_thread_budget(int max_threads);
+    static auto get_decoder_threads_in_use() -> int;
     
     auto get_frame_count() const -> std::optional<int>;
     auto get_duration() const -> std::optional<std::chrono::steady_clock::duration>;
     auto get_frame_size() const -> std::optional<std::tuple<int, int>>;
     auto get_frame_size_in_bytes() const -> std::optional<int>;
     auto get_fps() const -> std::optional<double>;
+    auto get_keyframe_count() const -> std::optional<int>;
+    auto get_decoder_threads() const -> std::optional<int>;
+    auto get_frame_pool_stats() const -> std::optional<frame_pool_stats>;
+    auto get_open_timings() const -> std::optional<open_timings>;
 
 protected:
+    friend class async_video_reader;
+
     void init();
+    bool prepare_input(decode_support decode_preference, const output_spec& output);
     bool open_input(const char* input, const AVInputFormat* input_format);
-    bool decode(AVPacket *packet);
+    bool reopen_input(const char* input);
+    bool is_same_stream(const AVCodecParameters* codecpar) const;
+    void apply_probe_options(AVFormatContext* format_ctx) const;
+    bool has_trusted_headers(const AVFormatContext* format_ctx) const;
+    bool find_stream_info(AVFormatContext* format_ctx) const;
+    bool decode();
+    // 0 on success, AVERROR_EOF at the end of the stream, a negative error code otherwise.
+    int demux(AVPacket* packet);
+    bool seek_timestamp(int64_t timestamp, seek_mode mode);
+    void set_decimation_interval(int64_t interval);
+    void update_skip_frame();
+    bool next_frame();
     bool convert(uint8_t** data, double* pts);
-    bool copy_hw_frame();
+    bool convert_frame(const AVFrame* src, frame& f);
+    bool init_sws_context(int src_format);
+    bool scale(const AVFrame* src, AVFrame* dst);
+    bool wrap_buffer(uint8_t* buffer, size_t size, AVFrame* dst);
+    double get_frame_pts(const AVFrame* f) const;
+    bool copy_hw_frame(const AVFrame* src, AVFrame* dst);
+    bool alloc_dst_frame(AVFrame* dst);
+    AVFrame* get_output_frame() const;
 
 private:
     bool _is_opened;
     std::mutex _open_mutex;
     decode_support _decode_support;
+    output_spec _output;
+    output_spec _requested_output;
 
     AVFormatContext* _format_ctx;
     AVCodecContext* _codec_ctx; 
@@ -68,9 +213,31 @@ private:
     
     AVDictionary* _options;
     int _stream_index;
+    bool _has_pending_frame;
+    int64_t _decimation_interval;
+    int64_t _next_output_pts;
+    bool _keyframes_only;
+    int _decoder_threads;
+    decoder_threading _decoder_threading;
+    int _granted_threads;
+    probe_options _probe_options;
+    open_timings _open_timings;
 
     class hw_acceleration;
     std::unique_ptr<hw_acceleration> _hw;
+
+    struct keyframe_index;
+    std::unique_ptr<keyframe_index> _keyframe_index;
+
+    struct mapped_file;
+    std::unique_ptr<mapped_file> _mapped_file;
+
+    struct custom_io;
+    std::unique_ptr<custom_io> _custom_io;
+
+    struct frame_pool;
+    struct frame_pool_deleter { void operator()(frame_pool* pool) const; };
+    std::unique_ptr<frame_pool, frame_pool_deleter> _frame_pool;
 };
 
 }
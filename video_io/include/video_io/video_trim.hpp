@@ -0,0 +1,35 @@
+#pragma once
+
+#include "api.hpp"
+
+#include <string>
+#include <chrono>
+
+namespace vio
+{
+/**
+ * keyframe: stream copy only, cuts are extended to the surrounding keyframes.
+ * smart: frame accurate, only the partial GOPs at both ends are decoded and re-encoded with the input codec, size and bit rate,
+ * the GOPs in between are copied. Needs an encoder for the input codec (e.g. libx264 for H.264).
+ * Limitation: the re-encoded GOPs carry their own parameter sets in band, with the same ids as the input ones but different
+ * content. MP4 / MOV outputs of H.264 and HEVC are therefore tagged avc3 / hev1 instead of avc1 / hvc1. Other containers
+ * (e.g. Matroska) only store the input parameter sets in their headers: decoders relying on them alone may fail at the splice points.
+*/
+enum class trim_mode { keyframe, smart };
+
+/**
+ * Stream copy from input_path to output_path: packets are copied without decoding nor encoding, so quality is preserved
+ * and the cost is mostly IO. The output container is deduced from the output_path extension.
+ * Video, audio and subtitle streams are kept, other streams (data, attachments) are dropped.
+*/
+API_VIDEO_IO bool remux(const std::string& input_path, const std::string& output_path);
+
+/**
+ * Copy of [start, end) from input_path to output_path. In keyframe mode cuts are keyframe aligned: the output
+ * starts at the last video keyframe at or before start and ends before the first video keyframe at or after end,
+ * so it can be up to a GOP longer on each side than requested. Output timestamps start at 0.
+*/
+API_VIDEO_IO bool trim(const std::string& input_path, const std::string& output_path,
+    std::chrono::steady_clock::duration start, std::chrono::steady_clock::duration end, trim_mode mode = trim_mode::keyframe);
+
+}
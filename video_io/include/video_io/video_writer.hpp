@@ -1,11 +1,16 @@
 #pragma once
 
 #include "api.hpp"
+#include "frame.hpp"
 
 #include <string>
+#include <vector>
+#include <map>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <optional>
+#include <tuple>
 #include <chrono>
 #include <mutex>
 
@@ -16,11 +21,93 @@ struct AVPacket;
 struct AVFrame;
 struct SwsContext;
 struct AVStream;
+struct AVDictionary;
 
 namespace vio
 {
 struct simple_frame;
 
+/**
+ * Encoded output sent to user callbacks instead of a file, e.g. for chunked uploads.
+ * write: consume size bytes, return size or < 0 on error. Called with chunks of at most buffer_size bytes.
+ * seek: fseek-like, optional. Without it muxers cannot patch headers once written: use fragmented MP4 or a streamable format.
+ * format: container short name (e.g. "mp4", "matroska", "mpegts"), there is no file extension to guess it from.
+ * fragmented: MP4 only, a self-contained fragment (moof + mdat) is emitted at each keyframe instead of a single moov at the end.
+*/
+struct output_sink
+{
+    output_sink(std::string format = "mp4", int buffer_size = 64 * 1024, bool fragmented = false)
+    : format{ std::move(format) }, buffer_size{ buffer_size }, fragmented{ fragmented } { }
+
+    std::function<int(const uint8_t* data, int size)> write;
+    std::function<int64_t(int64_t offset, int whence)> seek;
+    std::string format;
+    int buffer_size;
+    bool fragmented;
+};
+
+// Sink writing into buffer (cleared first), which must outlive the writer.
+API_VIDEO_IO output_sink memory_sink(std::vector<uint8_t>& buffer, const std::string& format = "mp4");
+
+/**
+ * Rolling output: the stream is cut into files of about duration each, on a forced keyframe (IDR) so that every segment
+ * plays on its own. A single encoder runs for the whole stream: no stall nor quality reset at segment boundaries.
+ * pattern: output path with the segment number as a printf integer, e.g. "record_%05d.mp4" or "live_%d.ts".
+ * reset_timestamps: each segment starts at 0. HLS expects continuous timestamps across MPEG-TS segments: set it to false.
+ * on_segment: called with the path of each completed segment, from write() or save().
+*/
+struct segment_spec
+{
+    segment_spec(std::string pattern = {}, std::chrono::milliseconds duration = std::chrono::seconds(10), bool reset_timestamps = true)
+    : pattern{ std::move(pattern) }, duration{ duration }, reset_timestamps{ reset_timestamps } { }
+
+    std::string pattern;
+    std::chrono::milliseconds duration;
+    bool reset_timestamps;
+    std::function<void(const std::string& path)> on_segment;
+};
+
+/**
+ * Layout of the frames passed to write(), converted to the encoder pixel format and output size in a single sws_scale pass.
+ * A width or height of 0 means the same as the output video. native: frames are already in the encoder pixel format.
+ * Frames matching the encoder layout are not converted, nor even copied when the encoder has no delay.
+*/
+struct input_spec
+{
+    input_spec(pixel_format format = pixel_format::yuv420p, int width = 0, int height = 0, scale_algorithm scaler = scale_algorithm::bicubic)
+    : format{ format }, width{ width }, height{ height }, scaler{ scaler } { }
+
+    pixel_format format;
+    int width;
+    int height;
+    scale_algorithm scaler;
+};
+
+/**
+ * Encoder settings. codec: encoder name (e.g. "libx264", "libx265", "mpeg4"), empty for the container default.
+ * Rate control: constant quality when crf >= 0 (x264/x265 scale), otherwise bit_rate, capped by max_bit_rate over rc_buffer_size when set.
+ * max_b_frames < 0 keeps the codec default, threads == 0 lets the encoder pick one thread per core.
+ * options: encoder private options passed as is to avcodec_open2 (e.g. "x264-params"). Unknown options are ignored and logged.
+*/
+struct encoder_spec
+{
+    encoder_spec(std::string codec = {})
+    : codec{ std::move(codec) }, crf{ -1 }, bit_rate{ 400000 }, max_bit_rate{ 0 }, rc_buffer_size{ 0 }
+    , gop_size{ 12 }, max_b_frames{ -1 }, threads{ 0 } { }
+
+    std::string codec;
+    std::string preset;
+    std::string tune;
+    int crf;
+    int64_t bit_rate;
+    int64_t max_bit_rate;
+    int rc_buffer_size;
+    int gop_size;
+    int max_b_frames;
+    int threads;
+    std::map<std::string, std::string> options;
+};
+
 class API_VIDEO_IO video_writer
 {
 public:
@@ -32,17 +119,45 @@ public:
 
     bool open(const std::string& video_path, int width, int height, const int fps);
     bool open(const std::string& video_path, int width, int height, const int fps, const int duration);
+    bool open(const output_sink& sink, int width, int height, const int fps);
+    bool open(const segment_spec& segments, int width, int height, const int fps);
+    // Take effect at the next open.
+    bool set_input(const input_spec& input);
+    bool set_encoder(const encoder_spec& encoder);
+    // Time base of the pts passed to write(data, pts), e.g. 1/1000 for milliseconds or 1/90000. Default (0/0): 1/fps.
+    // MPEG-1/2 only accept their standard frame rates as time base.
+    bool set_time_base(int num, int den);
     bool is_opened() const;
+    // Frame pts is the previous one + 1 (constant frame rate).
     bool write(const uint8_t* data);
+    // Variable frame rate: pts in the set_time_base unit, strictly increasing. Gaps are not filled with duplicate frames.
+    bool write(const uint8_t* data, int64_t pts);
     bool release();
     bool save();
     
     bool check(const std::string& video_path);
 
 protected:
+    friend class async_video_writer;
+
     void init();
-    bool convert(const uint8_t* data);
+    bool init_stream(int width, int height, int fps);
+    bool add_stream(int fps);
+    const AVCodec* find_encoder() const;
+    bool open_encoder(const AVCodec* codec);
+    bool write_header(AVDictionary** options);
+    // dst: frame with buffers in the encoder layout, converted into instead of the writer frame.
+    AVFrame* convert(const uint8_t* data, int64_t pts, AVFrame* dst = nullptr);
+    bool is_encoded_in_place() const;
+    bool wrap_buffer(const uint8_t* data, size_t size, AVFrame* dst);
+    int get_input_format() const;
+    std::tuple<int, int> get_input_size() const;
     bool encode(AVFrame* frame);
+    bool write_packet(AVPacket* packet);
+    bool open_segment();
+    bool close_segment();
+    bool rotate_segment();
+    void mark_segment_boundary(AVFrame* frame);
 
     AVFrame* alloc_frame(int pix_fmt, int width, int height);
 
@@ -61,7 +176,20 @@ private:
     AVStream* _stream;
     int64_t _stream_duration;
     int64_t _next_pts;
-    
+    input_spec _input;
+    encoder_spec _encoder;
+    int _time_base_num;
+    int _time_base_den;
+
+    struct sink_io;
+    std::unique_ptr<sink_io> _sink_io;
+
+    segment_spec _segments;
+    std::string _segment_path;
+    int _segment_index;
+    int64_t _segment_boundary_pts;
+    int64_t _segment_start_dts;
+    std::deque<int64_t> _segment_splits;
 };
 
 }
@@ -0,0 +1,277 @@
+#include <video_io/async_video_reader.hpp>
+#include "logger.hpp"
+#include "bounded_queue.hpp"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+#include <thread>
+
+namespace vio
+{
+struct async_video_reader::pipeline
+{
+    explicit pipeline(size_t queue_depth)
+    : packets{ queue_depth }
+    , frames{ queue_depth }
+    , output{ queue_depth }
+    { }
+
+    void close()
+    {
+        packets.close();
+        frames.close();
+        output.close();
+    }
+
+    void drain()
+    {
+        AVPacket* packet = nullptr;
+        while (packets.try_get(&packet))
+            av_packet_free(&packet);
+
+        AVFrame* decoded = nullptr;
+        while (frames.try_get(&decoded))
+            av_frame_free(&decoded);
+
+        frame f;
+        while (output.try_get(&f))
+            f.reset();
+    }
+
+    bounded_queue<AVPacket*> packets;
+    bounded_queue<AVFrame*> frames;
+    bounded_queue<frame> output;
+
+    std::thread demux_thread;
+    std::thread decode_thread;
+    std::thread convert_thread;
+};
+
+async_video_reader::async_video_reader(size_t queue_depth) noexcept
+: _is_opened{ false }
+, _queue_depth{ queue_depth }
+, _reader{ std::make_unique<video_reader>() }
+{
+}
+
+async_video_reader::~async_video_reader() noexcept
+{
+    release();
+}
+
+bool async_video_reader::open(const char* video_path, decode_support decode_preference, const output_spec& output)
+{
+    std::lock_guard lock(_open_mutex);
+    release();
+
+    if (!_reader->open(video_path, decode_preference, output))
+        return false;
+
+    _pipeline = std::make_unique<pipeline>(_queue_depth);
+    _pipeline->demux_thread = std::thread(&async_video_reader::demux_thread, this);
+    _pipeline->decode_thread = std::thread(&async_video_reader::decode_thread, this);
+    _pipeline->convert_thread = std::thread(&async_video_reader::convert_thread, this);
+
+    _is_opened = true;
+    log_info("Async Video Reader is opened correctly");
+    return true;
+}
+
+bool async_video_reader::is_opened() const
+{
+    return _is_opened;
+}
+
+bool async_video_reader::read(frame& f)
+{
+    if(!_is_opened)
+        return false;
+
+    return _pipeline->output.get(&f);
+}
+
+bool async_video_reader::try_read(frame& f)
+{
+    if(!_is_opened)
+        return false;
+
+    return _pipeline->output.try_get(&f);
+}
+
+bool async_video_reader::set_decoder_threads(int count, decoder_threading model)
+{
+    return _reader->set_decoder_threads(count, model);
+}
+
+bool async_video_reader::release()
+{
+    if(!_is_opened)
+        return false;
+
+    log_info("Release async video reader");
+
+    // Closing every queue wakes up any stage blocked on a full or empty queue.
+    _pipeline->close();
+    _pipeline->demux_thread.join();
+    _pipeline->decode_thread.join();
+    _pipeline->convert_thread.join();
+    _pipeline->drain();
+    _pipeline.reset();
+
+    _reader->release();
+    _is_opened = false;
+    return true;
+}
+
+void async_video_reader::demux_thread()
+{
+    while(true)
+    {
+        AVPacket* packet = av_packet_alloc();
+        if (!packet)
+        {
+            log_error("av_packet_alloc");
+            break;
+        }
+
+        if (auto r = _reader->demux(packet); r < 0)
+        {
+            // A read error also stops the decode stage: the decoder is not drained as if the stream had ended.
+            if (r != AVERROR_EOF)
+                _pipeline->frames.close();
+
+            av_packet_free(&packet);
+            break;
+        }
+
+        if (!_pipeline->packets.put(packet))
+        {
+            av_packet_free(&packet);
+            break;
+        }
+    }
+
+    // End of stream: the decode stage drains the decoder once the remaining packets are consumed.
+    _pipeline->packets.close();
+}
+
+void async_video_reader::decode_thread()
+{
+    AVCodecContext* codec_ctx = _reader->_codec_ctx;
+    AVPacket* packet = nullptr;
+
+    bool is_decoding = true;
+    while(is_decoding)
+    {
+        // No more packets: send a null packet to enter draining mode and flush the buffered frames.
+        const bool has_packet = _pipeline->packets.get(&packet);
+        const auto r = avcodec_send_packet(codec_ctx, has_packet ? packet : nullptr);
+        if (has_packet)
+            av_packet_free(&packet);
+
+        if (r < 0)
+        {
+            log_error("avcodec_send_packet", vio::logger::get().err2str(r));
+            break;
+        }
+
+        while(true)
+        {
+            AVFrame* decoded = av_frame_alloc();
+            if (!decoded)
+            {
+                log_error("av_frame_alloc");
+                is_decoding = false;
+                break;
+            }
+
+            if (auto r = avcodec_receive_frame(codec_ctx, decoded); r < 0)
+            {
+                av_frame_free(&decoded);
+                is_decoding = has_packet && r == AVERROR(EAGAIN);
+                break;
+            }
+
+            if (!_pipeline->frames.put(decoded))
+            {
+                av_frame_free(&decoded);
+                is_decoding = false;
+                break;
+            }
+        }
+    }
+
+    // Closing the input as well stops the demux stage if decoding ended early.
+    _pipeline->packets.close();
+    _pipeline->frames.close();
+}
+
+void async_video_reader::convert_thread()
+{
+    AVFrame* hw_frame = nullptr;
+    if (_reader->_decode_support == decode_support::HW)
+    {
+        if (hw_frame = av_frame_alloc(); !hw_frame)
+            log_error("av_frame_alloc");
+    }
+
+    AVFrame* decoded = nullptr;
+    while(_pipeline->frames.get(&decoded))
+    {
+        AVFrame* src = decoded;
+        if (hw_frame)
+        {
+            if (!_reader->copy_hw_frame(decoded, hw_frame))
+            {
+                av_frame_free(&decoded);
+                break;
+            }
+
+            src = hw_frame;
+        }
+
+        frame f;
+        const bool is_converted = _reader->convert_frame(src, f);
+        av_frame_free(&decoded);
+
+        if (!is_converted || !_pipeline->output.put(std::move(f)))
+            break;
+    }
+
+    if (hw_frame)
+        av_frame_free(&hw_frame);
+
+    _pipeline->frames.close();
+    _pipeline->output.close();
+}
+
+auto async_video_reader::get_frame_count() const -> std::optional<int>
+{
+    return _reader->get_frame_count();
+}
+
+auto async_video_reader::get_duration() const -> std::optional<std::chrono::steady_clock::duration>
+{
+    return _reader->get_duration();
+}
+
+auto async_video_reader::get_frame_size() const -> std::optional<std::tuple<int, int>>
+{
+    return _reader->get_frame_size();
+}
+
+auto async_video_reader::get_frame_size_in_bytes() const -> std::optional<int>
+{
+    return _reader->get_frame_size_in_bytes();
+}
+
+auto async_video_reader::get_fps() const -> std::optional<double>
+{
+    return _reader->get_fps();
+}
+
+}
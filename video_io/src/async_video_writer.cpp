@@ -0,0 +1,522 @@
+#include <video_io/async_video_writer.hpp>
+#include "logger.hpp"
+#include "bounded_queue.hpp"
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+}
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace vio
+{
+/**
+ * Travels through the three queues behind the frames written before flush().
+ * Resolved with false when dropped on the way (pipeline failure or release).
+*/
+class flush_marker
+{
+public:
+    explicit flush_marker() : _is_resolved{ false } { }
+    ~flush_marker() { resolve(false); }
+
+    std::future<bool> get_future() { return _promise.get_future(); }
+
+    void resolve(bool is_flushed)
+    {
+        if (_is_resolved)
+            return;
+
+        _promise.set_value(is_flushed);
+        _is_resolved = true;
+    }
+
+private:
+    std::promise<bool> _promise;
+    bool _is_resolved;
+};
+
+struct async_video_writer::pipeline
+{
+    struct frame_deleter { void operator()(AVFrame* f) const { av_frame_free(&f); } };
+    struct packet_deleter { void operator()(AVPacket* p) const { av_packet_free(&p); } };
+
+    // Each item is either a frame or a flush marker.
+    struct input_item
+    {
+        std::vector<uint8_t> data;
+        std::shared_ptr<flush_marker> flushed;
+    };
+
+    struct frame_item
+    {
+        std::unique_ptr<AVFrame, frame_deleter> frame;
+        // Set when the frame points into the queued buffer (in place conversion).
+        std::vector<uint8_t> data;
+        std::shared_ptr<flush_marker> flushed;
+    };
+
+    struct packet_item
+    {
+        std::unique_ptr<AVPacket, packet_deleter> packet;
+        std::shared_ptr<flush_marker> flushed;
+    };
+
+    explicit pipeline(size_t queue_depth)
+    : input{ queue_depth }
+    , frames{ queue_depth }
+    , packets{ queue_depth }
+    , buffers{ queue_depth }
+    , frame_buffers{ nullptr }
+    , frame_format{ -1 }
+    , frame_width{ 0 }
+    , frame_height{ 0 }
+    , is_failed{ false }
+    { }
+
+    // Outstanding pooled buffers (e.g. still referenced by the encoder) keep the pool alive until they are released.
+    ~pipeline() { av_buffer_pool_uninit(&frame_buffers); }
+
+    bool init_frame_buffers(int format, int width, int height)
+    {
+        const auto size = av_image_get_buffer_size(static_cast<AVPixelFormat>(format), width, height, frame_align);
+        if (size < 0)
+        {
+            log_error("av_image_get_buffer_size", vio::logger::get().err2str(size));
+            return false;
+        }
+
+        if (frame_buffers = av_buffer_pool_init(static_cast<size_t>(size), nullptr); !frame_buffers)
+        {
+            log_error("av_buffer_pool_init");
+            return false;
+        }
+
+        frame_format = format;
+        frame_width = width;
+        frame_height = height;
+        return true;
+    }
+
+    // Converted frames get their own buffer: it goes back to the pool once the encoder lets go of the frame.
+    std::unique_ptr<AVFrame, frame_deleter> get_frame()
+    {
+        std::unique_ptr<AVFrame, frame_deleter> frame{ av_frame_alloc() };
+        if (!frame)
+        {
+            log_error("av_frame_alloc");
+            return nullptr;
+        }
+
+        frame->format = frame_format;
+        frame->width = frame_width;
+        frame->height = frame_height;
+        if (frame->buf[0] = av_buffer_pool_get(frame_buffers); !frame->buf[0])
+        {
+            log_error("av_buffer_pool_get");
+            return nullptr;
+        }
+
+        if (auto r = av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data,
+            static_cast<AVPixelFormat>(frame_format), frame_width, frame_height, frame_align); r < 0)
+        {
+            log_error("av_image_fill_arrays", vio::logger::get().err2str(r));
+            return nullptr;
+        }
+
+        return frame;
+    }
+
+    void close()
+    {
+        input.close();
+        frames.close();
+        packets.close();
+    }
+
+    void drain()
+    {
+        input_item i;
+        while (input.try_get(&i))
+            i = {};
+
+        frame_item f;
+        while (frames.try_get(&f))
+            f = {};
+
+        packet_item p;
+        while (packets.try_get(&p))
+            p = {};
+    }
+
+    // Stops every stage and resolves the pending flush futures right away.
+    void fail()
+    {
+        is_failed = true;
+        close();
+        drain();
+    }
+
+    void recycle(std::vector<uint8_t>& data)
+    {
+        if (!data.empty())
+            buffers.try_put(data);
+    }
+
+    bounded_queue<input_item> input;
+    bounded_queue<frame_item> frames;
+    bounded_queue<packet_item> packets;
+
+    // Frame copies given back by the conversion and encode stages, reused by write() instead of allocating one per frame.
+    bounded_queue<std::vector<uint8_t>> buffers;
+
+    // Buffers of the converted frames, in the encoder layout.
+    static constexpr int frame_align = 32;
+    AVBufferPool* frame_buffers;
+    int frame_format;
+    int frame_width;
+    int frame_height;
+    std::atomic<bool> is_failed;
+
+    std::thread convert_thread;
+    std::thread encode_thread;
+    std::thread mux_thread;
+};
+
+async_video_writer::async_video_writer(size_t queue_depth, backpressure_policy policy) noexcept
+: _is_opened{ false }
+, _queue_depth{ queue_depth }
+, _policy{ policy }
+, _frame_size{ 0 }
+, _dropped_frames{ 0 }
+, _writer{ std::make_unique<video_writer>() }
+{
+}
+
+async_video_writer::~async_video_writer() noexcept
+{
+    release();
+}
+
+bool async_video_writer::open(const std::string& video_path, int width, int height, int fps)
+{
+    std::lock_guard lock(_open_mutex);
+    release();
+
+    if (!_writer->open(video_path, width, height, fps))
+        return false;
+
+    return start();
+}
+
+bool async_video_writer::open(const output_sink& sink, int width, int height, int fps)
+{
+    std::lock_guard lock(_open_mutex);
+    release();
+
+    if (!_writer->open(sink, width, height, fps))
+        return false;
+
+    return start();
+}
+
+bool async_video_writer::set_input(const input_spec& input)
+{
+    return _writer->set_input(input);
+}
+
+bool async_video_writer::set_encoder(const encoder_spec& encoder)
+{
+    return _writer->set_encoder(encoder);
+}
+
+bool async_video_writer::is_opened() const
+{
+    return _is_opened;
+}
+
+bool async_video_writer::write(const uint8_t* data)
+{
+    if(!_is_opened || _pipeline->is_failed)
+        return false;
+
+    // The caller may reuse its buffer as soon as write() returns.
+    pipeline::input_item item;
+    _pipeline->buffers.try_get(&item.data);
+    item.data.resize(_frame_size);
+    std::copy(data, data + _frame_size, item.data.begin());
+
+    switch (_policy)
+    {
+    case backpressure_policy::drop_newest:
+    {
+        if (_pipeline->input.try_put(item))
+            return true;
+
+        if (!_pipeline->input.is_closed())
+            ++_dropped_frames;
+
+        _pipeline->recycle(item.data);
+        return false;
+    }
+    case backpressure_policy::drop_oldest:
+    {
+        // Flush markers are never dropped.
+        std::optional<pipeline::input_item> dropped;
+        const bool is_queued = _pipeline->input.put_dropping(std::move(item),
+            [](const pipeline::input_item& i){ return !i.flushed; }, &dropped);
+
+        if (dropped)
+        {
+            ++_dropped_frames;
+            _pipeline->recycle(dropped->data);
+        }
+
+        return is_queued;
+    }
+    default:
+        return _pipeline->input.put(std::move(item));
+    }
+}
+
+std::future<bool> async_video_writer::flush()
+{
+    auto flushed = std::make_shared<flush_marker>();
+    auto is_flushed = flushed->get_future();
+
+    // Waits for room whatever the backpressure policy. When the marker cannot be queued,
+    // the last reference goes away with this function and the future is resolved with false.
+    if (_is_opened)
+        _pipeline->input.put({ {}, flushed });
+
+    return is_flushed;
+}
+
+bool async_video_writer::save()
+{
+    if(!_is_opened)
+        return false;
+
+    log_info("Save async video writer");
+
+    // Closing the input only: each stage finishes the queued items, then closes the next queue.
+    _pipeline->input.close();
+    if (!stop())
+    {
+        _writer->release();
+        return false;
+    }
+
+    // The stages are done: the encoder is drained and the trailer written on this thread.
+    return _writer->save();
+}
+
+bool async_video_writer::release()
+{
+    if(!_is_opened)
+        return false;
+
+    log_info("Release async video writer");
+
+    // Closing every queue wakes up any stage blocked on a full or empty queue.
+    _pipeline->close();
+    stop();
+
+    _writer->release();
+    return true;
+}
+
+auto async_video_writer::get_dropped_frames() const -> uint64_t
+{
+    return _dropped_frames;
+}
+
+bool async_video_writer::start()
+{
+    const auto [input_width, input_height] = _writer->get_input_size();
+    const auto input_format = static_cast<AVPixelFormat>(_writer->get_input_format());
+    const auto frame_size = av_image_get_buffer_size(input_format, input_width, input_height, 1);
+    if (frame_size < 0)
+    {
+        log_error("av_image_get_buffer_size", vio::logger::get().err2str(frame_size));
+        _writer->release();
+        return false;
+    }
+
+    _frame_size = static_cast<size_t>(frame_size);
+    _dropped_frames = 0;
+
+    _pipeline = std::make_unique<pipeline>(_queue_depth);
+
+    // Frames encoded in place point into the queued copies: no conversion buffer is needed.
+    const auto* codec_ctx = _writer->_codec_ctx;
+    if (!_writer->is_encoded_in_place() && !_pipeline->init_frame_buffers(codec_ctx->pix_fmt, codec_ctx->width, codec_ctx->height))
+    {
+        _pipeline.reset();
+        _writer->release();
+        return false;
+    }
+
+    _pipeline->convert_thread = std::thread(&async_video_writer::convert_thread, this);
+    _pipeline->encode_thread = std::thread(&async_video_writer::encode_thread, this);
+    _pipeline->mux_thread = std::thread(&async_video_writer::mux_thread, this);
+
+    _is_opened = true;
+    log_info("Async Video Writer is opened correctly");
+    return true;
+}
+
+bool async_video_writer::stop()
+{
+    _pipeline->convert_thread.join();
+    _pipeline->encode_thread.join();
+    _pipeline->mux_thread.join();
+
+    const bool is_failed = _pipeline->is_failed;
+    _pipeline->drain();
+    _pipeline.reset();
+
+    _is_opened = false;
+    return !is_failed;
+}
+
+void async_video_writer::convert_thread()
+{
+    pipeline::input_item item;
+    while(_pipeline->input.get(&item))
+    {
+        pipeline::frame_item converted;
+        converted.flushed = std::move(item.flushed);
+
+        if (!converted.flushed)
+        {
+            if (_pipeline->frame_buffers)
+            {
+                // Converted into a pooled frame: not shared with the next conversion, so never copied again.
+                if (auto frame = _pipeline->get_frame(); frame && _writer->convert(item.data.data(), _writer->_next_pts, frame.get()))
+                    converted.frame = std::move(frame);
+            }
+            else if (AVFrame* frame = _writer->convert(item.data.data(), _writer->_next_pts); frame)
+            {
+                // In place: the writer frame is reused by the next conversion, the encode stage gets its own reference.
+                // It points into the queued buffer, which must live until the frame is encoded.
+                converted.frame.reset(av_frame_clone(frame));
+                av_frame_unref(frame);
+                converted.data = std::move(item.data);
+            }
+
+            _pipeline->recycle(item.data);
+
+            if (!converted.frame)
+            {
+                log_error("Unable to convert frame");
+                _pipeline->fail();
+                break;
+            }
+        }
+
+        if (!_pipeline->frames.put(std::move(converted)))
+            break;
+    }
+
+    _pipeline->input.close();
+    _pipeline->frames.close();
+}
+
+void async_video_writer::encode_thread()
+{
+    AVCodecContext* codec_ctx = _writer->_codec_ctx;
+    pipeline::frame_item item;
+
+    bool is_encoding = true;
+    while(is_encoding && _pipeline->frames.get(&item))
+    {
+        // The packets of the frames sent so far are already queued: the marker follows them to the mux stage.
+        if (item.flushed)
+        {
+            is_encoding = _pipeline->packets.put({ nullptr, std::move(item.flushed) });
+            continue;
+        }
+
+        if (auto r = avcodec_send_frame(codec_ctx, item.frame.get()); r < 0)
+        {
+            log_error("avcodec_send_frame", vio::logger::get().err2str(r));
+            _pipeline->fail();
+            break;
+        }
+
+        while(true)
+        {
+            std::unique_ptr<AVPacket, pipeline::packet_deleter> packet{ av_packet_alloc() };
+            if (!packet)
+            {
+                log_error("av_packet_alloc");
+                _pipeline->fail();
+                is_encoding = false;
+                break;
+            }
+
+            if (auto r = avcodec_receive_packet(codec_ctx, packet.get()); r < 0)
+            {
+                if (r != AVERROR(EAGAIN))
+                {
+                    log_error("avcodec_receive_packet", vio::logger::get().err2str(r));
+                    _pipeline->fail();
+                    is_encoding = false;
+                }
+                break;
+            }
+
+            if (!_pipeline->packets.put({ std::move(packet), nullptr }))
+            {
+                is_encoding = false;
+                break;
+            }
+        }
+
+        // The encoder is done with the input frame: the queued buffer can be written again.
+        item.frame.reset();
+        _pipeline->recycle(item.data);
+    }
+
+    // The encoder is drained by save() once every stage is stopped.
+    _pipeline->frames.close();
+    _pipeline->packets.close();
+}
+
+void async_video_writer::mux_thread()
+{
+    AVFormatContext* format_ctx = _writer->_format_ctx;
+    pipeline::packet_item item;
+
+    while(_pipeline->packets.get(&item))
+    {
+        if (item.flushed)
+        {
+            // Push the AVIO buffer to the file or sink. Formats without a file (AVFMT_NOFILE) have no pb.
+            if (format_ctx->pb)
+                avio_flush(format_ctx->pb);
+
+            item.flushed->resolve(!_pipeline->is_failed);
+            item.flushed.reset();
+            continue;
+        }
+
+        if (!_writer->write_packet(item.packet.get()))
+        {
+            _pipeline->fail();
+            break;
+        }
+    }
+
+    _pipeline->packets.close();
+}
+
+}
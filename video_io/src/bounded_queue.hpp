@@ -0,0 +1,152 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <optional>
+
+namespace vio
+{
+/**
+ * Blocking FIFO with a maximum size, used to connect pipeline stages running on different threads.
+ * Once closed, put() fails and get() returns the remaining items before failing too.
+*/
+template <typename T>
+class bounded_queue
+{
+public:
+    using value_type = T;
+
+    explicit bounded_queue(size_t max_size)
+    : _max_size{ std::max<size_t>(max_size, 1) }
+    , _is_closed{ false }
+    {
+    }
+
+    bool put(value_type val)
+    {
+        unique_guard g(_lock);
+        _not_full.wait(g, [this]{ return _queue.size() < _max_size || _is_closed; });
+        if (_is_closed)
+            return false;
+
+        _queue.emplace_back(std::move(val));
+        g.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    // Never blocks: fails when the queue is full or closed, val is then left untouched.
+    bool try_put(value_type& val)
+    {
+        unique_guard g(_lock);
+        if (_queue.size() >= _max_size || _is_closed)
+            return false;
+
+        _queue.emplace_back(std::move(val));
+        g.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    // When the queue is full, the oldest item accepted by is_droppable is moved to dropped to make room for val.
+    // Blocks only when no queued item can be dropped.
+    template <typename Predicate>
+    bool put_dropping(value_type val, Predicate is_droppable, std::optional<value_type>* dropped)
+    {
+        unique_guard g(_lock);
+        while (true)
+        {
+            if (_is_closed)
+                return false;
+
+            if (_queue.size() < _max_size)
+                break;
+
+            if (auto it = std::find_if(_queue.begin(), _queue.end(), is_droppable); it != _queue.end())
+            {
+                dropped->emplace(std::move(*it));
+                _queue.erase(it);
+                break;
+            }
+
+            _not_full.wait(g);
+        }
+
+        _queue.emplace_back(std::move(val));
+        g.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    bool get(value_type* val)
+    {
+        unique_guard g(_lock);
+        _not_empty.wait(g, [this]{ return !_queue.empty() || _is_closed; });
+        if (_queue.empty())
+            return false;
+
+        *val = std::move(_queue.front());
+        _queue.pop_front();
+        g.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+
+    bool try_get(value_type* val)
+    {
+        unique_guard g(_lock);
+        if (_queue.empty())
+            return false;
+
+        *val = std::move(_queue.front());
+        _queue.pop_front();
+        g.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            guard g(_lock);
+            _is_closed = true;
+        }
+
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+
+    void reset()
+    {
+        guard g(_lock);
+        _queue.clear();
+        _is_closed = false;
+    }
+
+    bool is_closed() const
+    {
+        guard g(_lock);
+        return _is_closed;
+    }
+
+    size_t size() const
+    {
+        guard g(_lock);
+        return _queue.size();
+    }
+
+private:
+    using guard = std::lock_guard<std::mutex>;
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    mutable std::mutex _lock;
+    std::condition_variable _not_empty;
+    std::condition_variable _not_full;
+    size_t _max_size;
+    bool _is_closed;
+    std::deque<T> _queue;
+};
+
+}
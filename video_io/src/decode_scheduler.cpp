@@ -0,0 +1,352 @@
+#include <video_io/decode_scheduler.hpp>
+#include "logger.hpp"
+#include "bounded_queue.hpp"
+
+#include <deque>
+#include <algorithm>
+
+namespace vio
+{
+static constexpr size_t priority_levels = 3;
+
+struct decode_scheduler::stream
+{
+    explicit stream(size_t queue_depth, stream_priority priority)
+    : output{ queue_depth }
+    , priority{ priority }
+    , is_scheduled{ false }
+    , is_finished{ false }
+    { }
+
+    video_reader reader;
+    bounded_queue<frame> output;
+    std::atomic<stream_priority> priority;
+    std::atomic<bool> is_scheduled;
+    std::atomic<bool> is_finished;
+};
+
+struct decode_scheduler::worker_queue
+{
+    std::mutex lock;
+    std::deque<std::shared_ptr<stream>> tasks[priority_levels];
+};
+
+decode_scheduler::decode_scheduler(size_t worker_count, size_t queue_depth) noexcept
+: _queue_depth{ std::max<size_t>(queue_depth, 1) }
+, _is_running{ true }
+, _next_stream_id{ 0 }
+, _next_worker{ 0 }
+, _pending_tasks{ 0 }
+, _stopping{ false }
+{
+    if (worker_count == 0)
+        worker_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    log_info("Decode scheduler workers:", worker_count);
+
+    for (size_t i = 0; i < worker_count; ++i)
+        _queues.emplace_back(std::make_unique<worker_queue>());
+
+    for (size_t i = 0; i < worker_count; ++i)
+        _workers.emplace_back(&decode_scheduler::worker_thread, this, i);
+}
+
+decode_scheduler::~decode_scheduler() noexcept
+{
+    release();
+}
+
+auto decode_scheduler::add_stream(const char* video_path, decode_support decode_preference, const output_spec& output,
+    stream_priority priority) -> std::optional<int>
+{
+    if(!_is_running)
+    {
+        log_error("Stream not added. Decode scheduler is released.");
+        return std::nullopt;
+    }
+
+    auto s = std::make_shared<stream>(_queue_depth, priority);
+
+    // Parallelism comes from the worker pool: a single codec thread and conversion slice per stream avoids oversubscription.
+    output_spec single_threaded_output = output;
+    single_threaded_output.conversion_threads = 1;
+    s->reader.set_decoder_threads(1);
+
+    if (!s->reader.open(video_path, decode_preference, single_threaded_output))
+    {
+        log_error("Stream not added. Unable to open video path:", video_path);
+        return std::nullopt;
+    }
+
+    int stream_id = 0;
+    {
+        // Checked again under the lock taken by release(): a stream added during release would never be closed.
+        std::lock_guard lock(_streams_mutex);
+        if(!_is_running)
+        {
+            log_error("Stream not added. Decode scheduler is released.");
+            return std::nullopt;
+        }
+
+        stream_id = _next_stream_id++;
+        _streams.emplace(stream_id, s);
+    }
+
+    reschedule(s);
+    return std::make_optional(stream_id);
+}
+
+bool decode_scheduler::remove_stream(int stream_id)
+{
+    std::shared_ptr<stream> s;
+    {
+        std::lock_guard lock(_streams_mutex);
+        auto it = _streams.find(stream_id);
+        if (it == _streams.end())
+        {
+            log_error("Stream not removed. Invalid stream id:", stream_id);
+            return false;
+        }
+
+        s = std::move(it->second);
+        _streams.erase(it);
+    }
+
+    // A worker still holding the stream drops it after its current task, the reader is released with the last reference.
+    s->is_finished = true;
+    s->output.close();
+    return true;
+}
+
+bool decode_scheduler::set_priority(int stream_id, stream_priority priority)
+{
+    auto s = find_stream(stream_id);
+    if (!s)
+    {
+        log_error("Priority not set. Invalid stream id:", stream_id);
+        return false;
+    }
+
+    // Applies from the next task of the stream.
+    s->priority = priority;
+    return true;
+}
+
+bool decode_scheduler::read(int stream_id, frame& f)
+{
+    auto s = find_stream(stream_id);
+    if (!s || !s->output.get(&f))
+        return false;
+
+    reschedule(s);
+    return true;
+}
+
+bool decode_scheduler::try_read(int stream_id, frame& f)
+{
+    auto s = find_stream(stream_id);
+    if (!s || !s->output.try_get(&f))
+        return false;
+
+    reschedule(s);
+    return true;
+}
+
+bool decode_scheduler::release()
+{
+    // Closing the output queues wakes up the consumers blocked in read.
+    {
+        std::lock_guard lock(_streams_mutex);
+        if(!_is_running.exchange(false))
+            return false;
+
+        log_info("Release decode scheduler");
+        for (auto& [stream_id, s] : _streams)
+        {
+            s->is_finished = true;
+            s->output.close();
+        }
+    }
+
+    {
+        std::lock_guard lock(_wake_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+
+    for (auto& worker : _workers)
+        worker.join();
+
+    _workers.clear();
+
+    // The worker queues themselves are kept: a consumer returning from read may still reschedule its stream.
+    for (auto& q : _queues)
+    {
+        std::lock_guard lock(q->lock);
+        for (auto& tasks : q->tasks)
+            tasks.clear();
+    }
+
+    {
+        std::lock_guard lock(_streams_mutex);
+        _streams.clear();
+    }
+
+    return true;
+}
+
+void decode_scheduler::worker_thread(size_t worker_index)
+{
+    while(true)
+    {
+        std::shared_ptr<stream> s;
+        if (pop(worker_index, &s))
+        {
+            run(s, worker_index);
+            continue;
+        }
+
+        std::unique_lock lock(_wake_mutex);
+        _wake.wait(lock, [this]{ return _pending_tasks > 0 || _stopping; });
+        if (_stopping)
+            break;
+    }
+}
+
+void decode_scheduler::run(const std::shared_ptr<stream>& s, size_t worker_index)
+{
+    if (s->is_finished)
+    {
+        s->is_scheduled = false;
+        return;
+    }
+
+    frame f;
+    if (!s->reader.read(f) || !s->output.put(std::move(f)))
+    {
+        // End of stream or removed stream: consumers get the remaining frames, then read fails.
+        s->is_finished = true;
+        s->output.close();
+        s->is_scheduled = false;
+        return;
+    }
+
+    // Back at the end of this worker queue: other streams of the same priority run before the next frame of this one.
+    if (s->output.size() < _queue_depth)
+    {
+        schedule(s, worker_index);
+        return;
+    }
+
+    // Output queue full: the stream is scheduled again by the consumer. The consumer may have read a frame between
+    // the size check and the flag reset without rescheduling the stream, so check again.
+    s->is_scheduled = false;
+    if (s->output.size() < _queue_depth)
+        reschedule(s);
+}
+
+void decode_scheduler::schedule(const std::shared_ptr<stream>& s, size_t worker_index)
+{
+    {
+        auto& q = *_queues[worker_index];
+        std::lock_guard lock(q.lock);
+        q.tasks[static_cast<size_t>(s->priority.load())].push_back(s);
+    }
+
+    {
+        std::lock_guard lock(_wake_mutex);
+        ++_pending_tasks;
+    }
+    _wake.notify_one();
+}
+
+void decode_scheduler::reschedule(const std::shared_ptr<stream>& s)
+{
+    // At most one task per stream in flight: a reader is never used by two workers at the same time.
+    bool is_scheduled = false;
+    if (!_is_running || s->is_finished || !s->is_scheduled.compare_exchange_strong(is_scheduled, true))
+        return;
+
+    schedule(s, _next_worker++ % _queues.size());
+}
+
+bool decode_scheduler::pop(size_t worker_index, std::shared_ptr<stream>* s)
+{
+    const size_t worker_count = _queues.size();
+
+    // Highest priority first: a worker steals a high priority task before running its own lower priority ones.
+    for (size_t level = priority_levels; level-- > 0;)
+    {
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            const bool is_own_queue = i == 0;
+            auto& q = *_queues[(worker_index + i) % worker_count];
+
+            std::lock_guard lock(q.lock);
+            auto& tasks = q.tasks[level];
+            if (tasks.empty())
+                continue;
+
+            // Own queue in FIFO order for fairness, stolen tasks taken from the other end to limit contention.
+            if (is_own_queue)
+            {
+                *s = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            else
+            {
+                *s = std::move(tasks.back());
+                tasks.pop_back();
+            }
+
+            --_pending_tasks;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto decode_scheduler::find_stream(int stream_id) const -> std::shared_ptr<stream>
+{
+    std::lock_guard lock(_streams_mutex);
+    auto it = _streams.find(stream_id);
+    return it != _streams.end() ? it->second : nullptr;
+}
+
+auto decode_scheduler::get_worker_count() const -> size_t
+{
+    return _workers.size();
+}
+
+auto decode_scheduler::get_stream_count() const -> size_t
+{
+    std::lock_guard lock(_streams_mutex);
+    return _streams.size();
+}
+
+auto decode_scheduler::get_frame_size(int stream_id) const -> std::optional<std::tuple<int, int>>
+{
+    auto s = find_stream(stream_id);
+    if (!s)
+    {
+        log_error("Frame size not available. Invalid stream id:", stream_id);
+        return std::nullopt;
+    }
+
+    return s->reader.get_frame_size();
+}
+
+auto decode_scheduler::get_fps(int stream_id) const -> std::optional<double>
+{
+    auto s = find_stream(stream_id);
+    if (!s)
+    {
+        log_error("Fps not available. Invalid stream id:", stream_id);
+        return std::nullopt;
+    }
+
+    return s->reader.get_fps();
+}
+
+}
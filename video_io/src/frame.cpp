@@ -0,0 +1,139 @@
+#include <video_io/frame.hpp>
+#include "logger.hpp"
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+#include <utility>
+
+namespace vio
+{
+frame::frame() noexcept
+: _frame{ nullptr }
+, _pts{ 0.0 }
+{
+}
+
+frame::~frame() noexcept
+{
+    if(_frame)
+        av_frame_free(&_frame);
+}
+
+frame::frame(const frame& other) noexcept
+: frame()
+{
+    if(other._frame)
+        ref(other._frame, other._pts);
+}
+
+frame& frame::operator=(const frame& other) noexcept
+{
+    if(this == &other)
+        return *this;
+
+    if(other._frame)
+        ref(other._frame, other._pts);
+    else
+        reset();
+
+    return *this;
+}
+
+frame::frame(frame&& other) noexcept
+: _frame{ std::exchange(other._frame, nullptr) }
+, _pts{ std::exchange(other._pts, 0.0) }
+{
+}
+
+frame& frame::operator=(frame&& other) noexcept
+{
+    if(this == &other)
+        return *this;
+
+    if(_frame)
+        av_frame_free(&_frame);
+
+    _frame = std::exchange(other._frame, nullptr);
+    _pts = std::exchange(other._pts, 0.0);
+    return *this;
+}
+
+bool frame::ref(const AVFrame* src, double pts)
+{
+    if(!_frame)
+    {
+        if (_frame = av_frame_alloc(); !_frame)
+        {
+            log_error("av_frame_alloc");
+            return false;
+        }
+    }
+    else
+    {
+        av_frame_unref(_frame);
+    }
+
+    // Only the buffer references are incremented here: pixel data is shared, not copied.
+    if (auto r = av_frame_ref(_frame, src); r < 0)
+    {
+        log_error("av_frame_ref", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    _pts = pts;
+    return true;
+}
+
+bool frame::is_valid() const
+{
+    return _frame && _frame->buf[0];
+}
+
+void frame::reset()
+{
+    if(_frame)
+        av_frame_unref(_frame);
+
+    _pts = 0.0;
+}
+
+auto frame::get_data(int plane) const -> const uint8_t*
+{
+    if(!is_valid() || plane < 0 || plane >= AV_NUM_DATA_POINTERS)
+        return nullptr;
+
+    return _frame->data[plane];
+}
+
+auto frame::get_linesize(int plane) const -> int
+{
+    if(!is_valid() || plane < 0 || plane >= AV_NUM_DATA_POINTERS)
+        return 0;
+
+    return _frame->linesize[plane];
+}
+
+auto frame::get_width() const -> int
+{
+    return is_valid() ? _frame->width : 0;
+}
+
+auto frame::get_height() const -> int
+{
+    return is_valid() ? _frame->height : 0;
+}
+
+auto frame::get_format() const -> int
+{
+    return is_valid() ? _frame->format : -1;
+}
+
+auto frame::get_pts() const -> double
+{
+    return _pts;
+}
+
+}
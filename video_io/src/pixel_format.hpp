@@ -0,0 +1,39 @@
+#pragma once
+
+#include <video_io/frame.hpp>
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+namespace vio
+{
+inline AVPixelFormat to_av_pixel_format(pixel_format format)
+{
+    switch (format)
+    {
+        case pixel_format::bgr24:   return AV_PIX_FMT_BGR24;
+        case pixel_format::rgb24:   return AV_PIX_FMT_RGB24;
+        case pixel_format::rgba:    return AV_PIX_FMT_RGBA;
+        case pixel_format::gray8:   return AV_PIX_FMT_GRAY8;
+        case pixel_format::nv12:    return AV_PIX_FMT_NV12;
+        case pixel_format::yuv420p: return AV_PIX_FMT_YUV420P;
+        default:                    return AV_PIX_FMT_NONE;
+    }
+}
+
+inline int to_sws_flags(scale_algorithm scaler)
+{
+    switch (scaler)
+    {
+        case scale_algorithm::fast_bilinear: return SWS_FAST_BILINEAR;
+        case scale_algorithm::bilinear:      return SWS_BILINEAR;
+        case scale_algorithm::area:          return SWS_AREA;
+        case scale_algorithm::bicubic:
+        default:                             return SWS_BICUBIC;
+    }
+}
+
+}
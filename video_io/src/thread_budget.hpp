@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+namespace vio
+{
+/**
+ * Process-wide pool of decoder threads shared by all video readers.
+ * Readers acquire their codec threads at open and give them back at release, so that opening
+ * many streams does not oversubscribe the machine. A max_threads of 0 means unlimited.
+*/
+class thread_budget
+{
+public:
+    static thread_budget& get()
+    {
+        static thread_budget instance;
+        return instance;
+    }
+
+    void set_max_threads(int max_threads)
+    {
+        guard g(_lock);
+        _max_threads = std::max(max_threads, 0);
+    }
+
+    int get_max_threads() const
+    {
+        guard g(_lock);
+        return _max_threads;
+    }
+
+    int get_threads_in_use() const
+    {
+        guard g(_lock);
+        return _threads_in_use;
+    }
+
+    // requested == 0: as many threads as cores, bounded by what is left in the budget.
+    // A reader always gets at least one thread, even when the budget is exhausted.
+    int acquire(int requested)
+    {
+        guard g(_lock);
+        int granted = requested > 0 ? requested : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        if (_max_threads > 0)
+            granted = std::min(granted, _max_threads - _threads_in_use);
+
+        granted = std::max(granted, 1);
+        _threads_in_use += granted;
+        return granted;
+    }
+
+    void release(int granted)
+    {
+        guard g(_lock);
+        _threads_in_use = std::max(_threads_in_use - granted, 0);
+    }
+
+private:
+    thread_budget()
+    : _max_threads{ 0 }
+    , _threads_in_use{ 0 }
+    {
+    }
+
+    using guard = std::lock_guard<std::mutex>;
+
+    mutable std::mutex _lock;
+    int _max_threads;
+    int _threads_in_use;
+};
+
+}
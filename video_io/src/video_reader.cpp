@@ -1,6 +1,11 @@
 #include <video_io/video_reader.hpp>
 #include "logger.hpp"
 #include "video_reader_hw.hpp"
+#include "video_reader_index.hpp"
+#include "video_reader_pool.hpp"
+#include "video_reader_io.hpp"
+#include "pixel_format.hpp"
+#include "thread_budget.hpp"
 
 extern "C"
 {
@@ -10,15 +15,24 @@ extern "C"
 #include <libavutil/frame.h>
 #include <libavutil/buffer.h>
 #include <libavutil/hwcontext.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
 // #include <libavdevice/avdevice.h> // required for screen recording only
 }
 
-#include <thread>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
 
 namespace vio
 {
 video_reader::video_reader() noexcept
 : _is_opened{ false }
+, _decoder_threads{ 0 }
+, _decoder_threading{ decoder_threading::automatic }
+, _frame_pool{ new frame_pool() }
 {
     init(); 
     av_log_set_level(0);
@@ -37,6 +51,8 @@ void video_reader::init()
 
     _is_opened = false;
     _decode_support = decode_support::none;
+    _output = output_spec();
+    _requested_output = output_spec();
     
     _format_ctx = nullptr;
     _codec_ctx = nullptr; 
@@ -49,17 +65,89 @@ void video_reader::init()
     _sws_ctx = nullptr;
     _options = nullptr;
     _stream_index = -1;
+    _has_pending_frame = false;
+    _decimation_interval = 0;
+    _next_output_pts = AV_NOPTS_VALUE;
+    _keyframes_only = false;
+    _granted_threads = 0;
+    _open_timings = {};
 }
 
 // void video_reader::set_log_callback(const log_callback_t& cb, const log_level& level) { vio::logger::get().set_log_callback(cb, level); }
 
-bool video_reader::open(const char* video_path, decode_support decode_preference)
+bool video_reader::open(const char* video_path, decode_support decode_preference, const output_spec& output)
 {
     std::lock_guard lock(_open_mutex);
-    release();
 
     log_info("Opening video path:", video_path);
+    return prepare_input(decode_preference, output) && open_input(video_path, nullptr);
+}
+
+bool video_reader::open(const input_callbacks& input, decode_support decode_preference, const output_spec& output)
+{
+    if(!input.read)
+    {
+        log_error("open: a read callback is required");
+        return false;
+    }
+
+    std::lock_guard lock(_open_mutex);
+
+    log_info("Opening custom input");
+    if(!prepare_input(decode_preference, output))
+        return false;
+
+    if (_custom_io = std::make_unique<custom_io>(input); !_custom_io->init())
+    {
+        log_error("Unable to initialize custom input");
+        return false;
+    }
+
+    // Custom IO: avformat_close_input leaves the AVIOContext alone, _custom_io frees it after the format context.
+    _format_ctx->pb = _custom_io->avio_ctx;
+    _format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return open_input("", nullptr);
+}
+
+bool video_reader::open(const uint8_t* data, size_t size, decode_support decode_preference, const output_spec& output)
+{
+    if(!data || size == 0)
+    {
+        log_error("open: empty memory input");
+        return false;
+    }
+
+    return open(custom_io::memory_input(data, size), decode_preference, output);
+}
+
+bool video_reader::open_mapped(const char* video_path, decode_support decode_preference, const output_spec& output)
+{
+    log_info("Mapping video path:", video_path);
+
+    auto mapped = std::make_unique<mapped_file>();
+    if (!mapped->open(video_path))
+        return false;
+
+    // Kept after open returns: opening releases the previous mapping, if any.
+    const bool is_opened = open(mapped->input(), decode_preference, output);
+    _mapped_file = std::move(mapped);
+    return is_opened;
+}
+
+bool video_reader::prepare_input(decode_support decode_preference, const output_spec& output)
+{
+    if(output.width < 0 || output.height < 0)
+    {
+        log_error("open: invalid output size:", "width:", output.width, "height:", output.height);
+        return false;
+    }
+
+    release();
+
     log_info("HW acceleration", (decode_preference == decode_support::HW ? "required" : "not required"));
+    log_info("Output", "width:", output.width, "height:", output.height, "native:", output.format == pixel_format::native);
+    _output = output;
+    _requested_output = output;
 
     if(decode_preference == decode_support::HW)
     {
@@ -83,7 +171,7 @@ bool video_reader::open(const char* video_path, decode_support decode_preference
         return false;
     }
 
-    return open_input(video_path, nullptr);
+    return true;
 }
 
 bool video_reader::open(const char* screen_name, screen_options screen_opt)
@@ -151,19 +239,163 @@ bool video_reader::open(const char* screen_name, screen_options screen_opt)
     return open_input(screen_name, input_format);
 }
 
+bool video_reader::reopen(const char* video_path)
+{
+    if(!_is_opened)
+    {
+        log_error("Reopen failed. A video path must be opened first.");
+        return false;
+    }
+
+    const auto decode_preference = _decode_support;
+    const auto output = _requested_output;
+    {
+        std::lock_guard lock(_open_mutex);
+        if (reopen_input(video_path))
+            return true;
+    }
+
+    log_info("Stream parameters differ, opening from scratch:", video_path);
+    return open(video_path, decode_preference, output);
+}
+
+bool video_reader::reopen_input(const char* input)
+{
+    log_info("Reopening video path:", input);
+
+    AVFormatContext* format_ctx = nullptr;
+    if (format_ctx = avformat_alloc_context(); !format_ctx)
+    {
+        log_error("avformat_alloc_context");
+        return false;
+    }
+
+    apply_probe_options(format_ctx);
+
+    AVDictionary* options = nullptr;
+    av_dict_set(&options, "rtsp_transport", "tcp", 0);
+    if (auto r = avformat_open_input(&format_ctx, input, nullptr, &options); r < 0)
+    {
+        log_error("avformat_open_input", vio::logger::get().err2str(r));
+        av_dict_free(&options);
+        return false;
+    }
+    av_dict_free(&options);
+
+    if (!has_trusted_headers(format_ctx) && !find_stream_info(format_ctx))
+    {
+        avformat_close_input(&format_ctx);
+        return false;
+    }
+
+    const int stream_index = av_find_best_stream(format_ctx, AVMediaType::AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream_index < 0 || !is_same_stream(format_ctx->streams[stream_index]->codecpar))
+    {
+        avformat_close_input(&format_ctx);
+        return false;
+    }
+
+    // Only the demuxer changes: the decoder drops the frames buffered from the previous file and starts over.
+    avformat_close_input(&_format_ctx);
+    _custom_io.reset();
+    _mapped_file.reset();
+    _format_ctx = format_ctx;
+    _stream_index = stream_index;
+    avcodec_flush_buffers(_codec_ctx);
+    av_packet_unref(_packet);
+    av_frame_unref(_src_frame);
+
+    // Per file state is reset as a full open would do.
+    _has_pending_frame = false;
+    _decimation_interval = 0;
+    _next_output_pts = AV_NOPTS_VALUE;
+    _keyframes_only = false;
+    _keyframe_index.reset();
+    update_skip_frame();
+
+    log_info("Video Reader is reopened correctly");
+    return true;
+}
+
+bool video_reader::is_same_stream(const AVCodecParameters* codecpar) const
+{
+    const auto* current = _format_ctx->streams[_stream_index]->codecpar;
+
+    // Extradata carries the codec global headers (e.g. H.264 SPS/PPS): the decoder must be rebuilt when they change.
+    // Unprobed streams may not know their pixel format yet: it then comes from the SPS in the (compared) extradata.
+    const bool is_same_format = codecpar->format == current->format
+        || (codecpar->format == AV_PIX_FMT_NONE && codecpar->extradata_size > 0);
+
+    return codecpar->codec_id == current->codec_id
+        && codecpar->width == current->width
+        && codecpar->height == current->height
+        && is_same_format
+        && codecpar->extradata_size == current->extradata_size
+        && (codecpar->extradata_size == 0 || std::memcmp(codecpar->extradata, current->extradata, codecpar->extradata_size) == 0);
+}
+
+void video_reader::apply_probe_options(AVFormatContext* format_ctx) const
+{
+    if(_probe_options.probesize > 0)
+        format_ctx->probesize = _probe_options.probesize;
+
+    if(_probe_options.analyze_duration.count() > 0)
+        format_ctx->max_analyze_duration = _probe_options.analyze_duration.count();
+}
+
+bool video_reader::has_trusted_headers(const AVFormatContext* format_ctx) const
+{
+    if(!_probe_options.trust_container_headers)
+        return false;
+
+    const int stream_index = av_find_best_stream(const_cast<AVFormatContext*>(format_ctx), AVMediaType::AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream_index < 0)
+        return false;
+
+    // The pixel format is not required: MP4 and MKV do not store it for H.264 or HEVC, open_input takes it from the first frame.
+    const auto* stream = format_ctx->streams[stream_index];
+    const auto* codecpar = stream->codecpar;
+    if (codecpar->codec_id == AV_CODEC_ID_NONE || codecpar->width <= 0 || codecpar->height <= 0
+        || stream->avg_frame_rate.num <= 0 || stream->avg_frame_rate.den <= 0)
+        return false;
+
+    log_info("Stream parameters found in container headers, skipping avformat_find_stream_info");
+    return true;
+}
+
+bool video_reader::find_stream_info(AVFormatContext* format_ctx) const
+{
+    if (auto r = avformat_find_stream_info(format_ctx, nullptr); r < 0)
+    {
+        log_error("avformat_find_stream_info", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    return true;
+}
+
 bool video_reader::open_input(const char* input, const AVInputFormat* input_format)
 {
+    using clock = std::chrono::steady_clock;
+    const auto elapsed = [](clock::time_point since){ return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - since); };
+    const auto open_start = clock::now();
+
+    apply_probe_options(_format_ctx);
     if (auto r = avformat_open_input(&_format_ctx, input, input_format, &_options); r < 0)
     {
         log_error("avformat_open_input", vio::logger::get().err2str(r));
         return false;
     }
+    _open_timings.open_input = elapsed(open_start);
 
-    if (auto r = avformat_find_stream_info(_format_ctx, nullptr); r < 0)
+    if (!has_trusted_headers(_format_ctx))
     {
-        log_error("avformat_find_stream_info");
-        return false;
+        const auto probe_start = clock::now();
+        if (!find_stream_info(_format_ctx))
+            return false;
+        _open_timings.find_stream_info = elapsed(probe_start);
     }
+    const auto codec_start = clock::now();
 
 /* NOTE: this is a breaking change from ffmpeg v4.x to ffmpeg v5.x in function av_find_best_stream */
 #if LIBAVCODEC_VERSION_MAJOR <= 58
@@ -183,7 +415,6 @@ bool video_reader::open_input(const char* input, const AVInputFormat* input_form
         log_error("avcodec_alloc_context3");
         return false;
     }
-    _codec_ctx->thread_count = std::thread::hardware_concurrency();
 
     if (auto r = avcodec_parameters_to_context(_codec_ctx, _format_ctx->streams[_stream_index]->codecpar); r < 0)
     {
@@ -198,27 +429,43 @@ bool video_reader::open_input(const char* input, const AVInputFormat* input_form
         // _codec_ctx->hw_frames_ctx = _hw->get_frames_ctx(_codec_ctx->width, _codec_ctx->height);
     }
 
+    // Given back on every failure below: release() skips readers that are not opened.
+    _granted_threads = thread_budget::get().acquire(_decoder_threads);
+    _codec_ctx->thread_count = _granted_threads;
+    switch (_decoder_threading)
+    {
+        case decoder_threading::frame: _codec_ctx->thread_type = FF_THREAD_FRAME; break;
+        case decoder_threading::slice: _codec_ctx->thread_type = FF_THREAD_SLICE; break;
+        default:                       _codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE; break;
+    }
+    log_info("Decoder threads:", _granted_threads);
+
     if (auto r = avcodec_open2(_codec_ctx, codec, nullptr); r < 0)
     {
         log_error("avcodec_open2", vio::logger::get().err2str(r));
+        thread_budget::get().release(std::exchange(_granted_threads, 0));
         return false;
     }
+    _open_timings.open_codec = elapsed(codec_start);
 
     if (_packet = av_packet_alloc(); !_packet)
     {
         log_error("av_packet_alloc");
+        thread_budget::get().release(std::exchange(_granted_threads, 0));
         return false;
     }
     
     if (_src_frame = av_frame_alloc(); !_src_frame)
     {
         log_error("av_frame_alloc");
+        thread_budget::get().release(std::exchange(_granted_threads, 0));
         return false;
     }
 
     if (_dst_frame = av_frame_alloc(); !_dst_frame)
     {
         log_error("av_frame_alloc");
+        thread_budget::get().release(std::exchange(_granted_threads, 0));
         return false;
     }
 
@@ -228,6 +475,7 @@ bool video_reader::open_input(const char* input, const AVInputFormat* input_form
         if (_tmp_frame = av_frame_alloc(); !_tmp_frame)
         {
             log_error("av_frame_alloc");
+            thread_budget::get().release(std::exchange(_granted_threads, 0));
             return false;
         }
     }
@@ -237,22 +485,73 @@ bool video_reader::open_input(const char* input, const AVInputFormat* input_form
         _tmp_frame = _src_frame;
     }
 
-    _dst_frame->format = AVPixelFormat::AV_PIX_FMT_BGR24;
-	_dst_frame->width  = _codec_ctx->width;
-	_dst_frame->height = _codec_ctx->height;
-    if (auto r = av_frame_get_buffer(_dst_frame, 0); r < 0)
+    if(_output.width == 0)
+        _output.width = _codec_ctx->width;
+
+    if(_output.height == 0)
+        _output.height = _codec_ctx->height;
+
+    // Native output hands out decoded frames as they are: no destination buffer is needed.
+    if (_output.format != pixel_format::native && !alloc_dst_frame(_dst_frame))
     {
-        log_error("av_frame_get_buffer", vio::logger::get().err2str(r));
+        log_error("alloc_dst_frame");
+        thread_budget::get().release(std::exchange(_granted_threads, 0));
         return false;
     }
 
+    // Unprobed stream: the pixel format is only known once the decoder has seen the SPS. The frame is kept for the first read.
+    if (_codec_ctx->pix_fmt == AV_PIX_FMT_NONE)
+    {
+        if (!decode())
+        {
+            log_error("Unable to decode the first frame");
+            thread_budget::get().release(std::exchange(_granted_threads, 0));
+            return false;
+        }
+
+        _has_pending_frame = true;
+        _format_ctx->streams[_stream_index]->codecpar->format = _decode_support == decode_support::HW ? _codec_ctx->sw_pix_fmt : _codec_ctx->pix_fmt;
+    }
+
     // TODO: init _sws_ctx
 
+    _open_timings.total = elapsed(open_start);
     _is_opened = true;
     log_info("Video Reader is opened correctly");
     return true;
 }
 
+bool video_reader::alloc_dst_frame(AVFrame* dst)
+{
+    dst->format = to_av_pixel_format(_output.format);
+    dst->width  = _output.width;
+    dst->height = _output.height;
+
+    // Align 1: rows and planes are tightly packed, matching get_frame_size_in_bytes() for any output width.
+    // The padding leaves room for SIMD scalers writing past the end of the last row.
+    const auto size = av_image_get_buffer_size(static_cast<AVPixelFormat>(dst->format), dst->width, dst->height, 1);
+    if (size < 0)
+    {
+        log_error("av_image_get_buffer_size", vio::logger::get().err2str(size));
+        return false;
+    }
+
+    if (dst->buf[0] = _frame_pool->get(static_cast<size_t>(size) + AV_INPUT_BUFFER_PADDING_SIZE); !dst->buf[0])
+    {
+        log_error("Unable to get a buffer from the frame pool");
+        return false;
+    }
+
+    if (auto r = av_image_fill_arrays(dst->data, dst->linesize, dst->buf[0]->data, static_cast<AVPixelFormat>(dst->format), dst->width, dst->height, 1); r < 0)
+    {
+        log_error("av_image_fill_arrays", vio::logger::get().err2str(r));
+        av_buffer_unref(&dst->buf[0]);
+        return false;
+    }
+
+    return true;
+}
+
 bool video_reader::is_opened() const
 {
     return _is_opened;
@@ -299,7 +598,10 @@ auto video_reader::get_frame_size() const -> std::optional<std::tuple<int, int>>
         return std::nullopt;
     }
     
-    auto size = std::make_tuple(_codec_ctx->width, _codec_ctx->height);
+    if(_output.format == pixel_format::native)
+        return std::make_optional(std::make_tuple(_codec_ctx->width, _codec_ctx->height));
+
+    auto size = std::make_tuple(_output.width, _output.height);
     return std::make_optional(size);
 }
 
@@ -311,7 +613,17 @@ auto video_reader::get_frame_size_in_bytes() const -> std::optional<int>
         return std::nullopt;
     }
 
-    auto bytes = _codec_ctx->width * _codec_ctx->height * 3;
+    if(_output.format == pixel_format::native)
+    {
+        const auto native_format = _decode_support == decode_support::HW ? _codec_ctx->sw_pix_fmt : _codec_ctx->pix_fmt;
+        if (auto bytes = av_image_get_buffer_size(native_format, _codec_ctx->width, _codec_ctx->height, 1); bytes > 0)
+            return std::make_optional(bytes);
+
+        log_info("Unable to compute native frame size in bytes.");
+        return std::nullopt;
+    }
+
+    auto bytes = av_image_get_buffer_size(to_av_pixel_format(_output.format), _output.width, _output.height, 1);
     return std::make_optional(bytes);
 }
 
@@ -334,57 +646,83 @@ auto video_reader::get_fps() const -> std::optional<double>
     return std::make_optional(fps);
 }
 
-bool video_reader::decode(AVPacket *packet)
+bool video_reader::decode()
 {
     while(true)
     {
-        if (packet->stream_index != _stream_index)
+        if (auto r = avcodec_receive_frame(_codec_ctx, _src_frame); r == 0)
         {
-            av_packet_unref(packet);
-            continue;
+            return true;
         }
-
-        if (auto r = avcodec_send_packet(_codec_ctx, packet); r < 0)
+        else if (r != AVERROR(EAGAIN))
         {
-            log_error("avcodec_send_packet", r);
-            av_packet_unref(packet);
+            log_info("avcodec_receive_frame", vio::logger::get().err2str(r));
             return false;
         }
 
-        if (auto r = avcodec_receive_frame(_codec_ctx, _src_frame); r < 0)
+        // The decoder needs more input: at the end of the stream enter draining mode instead,
+        // so that frames still buffered in the decoder are returned.
+        // A read error is not the end of the stream: stop instead of draining.
+        const auto demuxed = demux(_packet);
+        if (demuxed < 0 && demuxed != AVERROR_EOF)
+            return false;
+
+        const auto r = avcodec_send_packet(_codec_ctx, demuxed == 0 ? _packet : nullptr);
+        av_packet_unref(_packet);
+        if (r < 0)
         {
-            if (AVERROR(EAGAIN) == r) // if(r == AVERROR_EOF || r == AVERROR(EAGAIN))
-                continue; 
-            
-            av_packet_unref(packet);
-            log_info("avcodec_receive_frame", vio::logger::get().err2str(r));
+            log_error("avcodec_send_packet", vio::logger::get().err2str(r));
             return false;
         }
-        
-        av_packet_unref(packet);
-        return true;
     }
 }
 
-bool video_reader::copy_hw_frame()
+int video_reader::demux(AVPacket* packet)
 {
-    if (_src_frame->format == _hw->hw_pixel_format)
+    while(true)
     {
-        if (auto r = av_hwframe_transfer_data(_tmp_frame, _src_frame, 0); r < 0)
+        if (auto r = av_read_frame(_format_ctx, packet); r < 0)
         {
-            log_error("av_hwframe_transfer_data", vio::logger::get().err2str(r));
-            return false;
+            if (r != AVERROR_EOF)
+                log_error("av_read_frame", vio::logger::get().err2str(r));
+
+            return r;
         }
 
-        if (auto r = av_frame_copy_props(_tmp_frame, _src_frame); r < 0)
+        // Keyframes only: non-key packets are dropped before they ever reach the decoder.
+        if (packet->stream_index == _stream_index && (!_keyframes_only || (packet->flags & AV_PKT_FLAG_KEY)))
+            return 0;
+
+        av_packet_unref(packet);
+    }
+}
+
+bool video_reader::copy_hw_frame(const AVFrame* src, AVFrame* dst)
+{
+    // Drop the previous buffer rather than overwriting it: a vio::frame may still reference it.
+    av_frame_unref(dst);
+
+    if (src->format != _hw->hw_pixel_format)
+    {
+        if (auto r = av_frame_ref(dst, src); r < 0)
         {
-            log_error("av_frame_copy_props", vio::logger::get().err2str(r));
+            log_error("av_frame_ref", vio::logger::get().err2str(r));
             return false;
         }
+
+        return true;
     }
-    else
+
+    if (auto r = av_hwframe_transfer_data(dst, src, 0); r < 0)
     {
-        _tmp_frame = _src_frame;
+        log_error("av_hwframe_transfer_data", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    if (auto r = av_frame_copy_props(dst, src); r < 0)
+    {
+        log_error("av_frame_copy_props", vio::logger::get().err2str(r));
+        return false;
     }
 
     return true;
@@ -394,66 +732,635 @@ bool video_reader::convert(uint8_t** data, double* pts)
 {   
     if(_decode_support == decode_support::HW)
     {
-        if(!copy_hw_frame())
+        if(!copy_hw_frame(_src_frame, _tmp_frame))
             return false;
     }
 
-    if (!_sws_ctx)
+    if(pts)
+        *pts = get_frame_pts(_tmp_frame);
+
+    if(_output.format == pixel_format::native)
+    {
+        // Passthrough: the decoded frame is handed out as it is, skipping sws_scale entirely.
+        *data = _tmp_frame->data[0];
+        return true;
+    }
+
+    // A frame returned by read(frame&) may still hold a reference to the current buffer:
+    // never overwrite it, rather swap in a new buffer and leave the old one to its owner.
+    if (!av_frame_is_writable(_dst_frame))
+    {
+        av_frame_unref(_dst_frame);
+        if (!alloc_dst_frame(_dst_frame))
+            return false;
+    }
+
+    if (!scale(_tmp_frame, _dst_frame))
+        return false;
+
+    *data = _dst_frame->data[0];
+    return true;
+}
+
+bool video_reader::convert_frame(const AVFrame* src, frame& f)
+{
+    const auto pts = get_frame_pts(src);
+    if(_output.format == pixel_format::native)
+        return f.ref(src, pts);
+
+    // Every converted frame gets its own buffer: the returned handle is its only owner.
+    AVFrame* dst = av_frame_alloc();
+    if (!dst)
+    {
+        log_error("av_frame_alloc");
+        return false;
+    }
+
+    const bool converted = alloc_dst_frame(dst) && scale(src, dst) && f.ref(dst, pts);
+    av_frame_free(&dst);
+    return converted;
+}
+
+bool video_reader::init_sws_context(int src_format)
+{
+#if LIBSWSCALE_VERSION_MAJOR >= 6
+    // Threaded swscale: the picture is split in horizontal slices, each one scaled by its own slice context on a worker thread.
+    if (_sws_ctx = sws_alloc_context(); !_sws_ctx)
+    {
+        log_error("sws_alloc_context");
+        return false;
+    }
+
+    const std::pair<const char*, int64_t> sws_options[] = {
+        { "srcw", _codec_ctx->width },
+        { "srch", _codec_ctx->height },
+        { "src_format", src_format },
+        { "dstw", _output.width },
+        { "dsth", _output.height },
+        { "dst_format", to_av_pixel_format(_output.format) },
+        { "sws_flags", to_sws_flags(_output.scaler) },
+        { "threads", _output.conversion_threads },
+    };
+
+    for (const auto& [name, value] : sws_options)
     {
-        _sws_ctx = sws_getCachedContext(_sws_ctx,
-            _codec_ctx->width, _codec_ctx->height, (AVPixelFormat)_tmp_frame->format,
-            _codec_ctx->width, _codec_ctx->height, AVPixelFormat::AV_PIX_FMT_BGR24,
-            SWS_BICUBIC, nullptr, nullptr, nullptr);
-        
-        if (!_sws_ctx)
+        if (auto r = av_opt_set_int(_sws_ctx, name, value, 0); r < 0)
         {
-            log_error("Unable to initialize SwsContext");
+            log_error("av_opt_set_int", name, vio::logger::get().err2str(r));
             return false;
         }
     }
 
-    // _dst_frame->linesize[0] = _codec_ctx->width * 3;
-    sws_scale(_sws_ctx, _tmp_frame->data, _tmp_frame->linesize, 0, _codec_ctx->height, _dst_frame->data, _dst_frame->linesize);
+    if (auto r = sws_init_context(_sws_ctx, nullptr, nullptr); r < 0)
+    {
+        log_error("sws_init_context", vio::logger::get().err2str(r));
+        return false;
+    }
+#else
+    _sws_ctx = sws_getCachedContext(_sws_ctx,
+        _codec_ctx->width, _codec_ctx->height, (AVPixelFormat)src_format,
+        _output.width, _output.height, to_av_pixel_format(_output.format),
+        to_sws_flags(_output.scaler), nullptr, nullptr, nullptr);
 
-    *data = _dst_frame->data[0];
+    if (!_sws_ctx)
+    {
+        log_error("Unable to initialize SwsContext");
+        return false;
+    }
+#endif
 
-    if(pts)
+    return true;
+}
+
+bool video_reader::scale(const AVFrame* src, AVFrame* dst)
+{
+    if (!_sws_ctx && !init_sws_context(src->format))
+    {
+        sws_freeContext(_sws_ctx);
+        _sws_ctx = nullptr;
+        return false;
+    }
+
+#if LIBSWSCALE_VERSION_MAJOR >= 6
+    if (auto r = sws_scale_frame(_sws_ctx, dst, src); r < 0)
     {
-        const auto time_base = _format_ctx->streams[_stream_index]->time_base;
-        *pts = _tmp_frame->best_effort_timestamp * static_cast<double>(time_base.num) / static_cast<double>(time_base.den);
+        log_error("sws_scale_frame", vio::logger::get().err2str(r));
+        return false;
     }
+#else
+    sws_scale(_sws_ctx, src->data, src->linesize, 0, _codec_ctx->height, dst->data, dst->linesize);
+#endif
 
     return true;
 }
 
+double video_reader::get_frame_pts(const AVFrame* f) const
+{
+    const auto time_base = _format_ctx->streams[_stream_index]->time_base;
+    return f->best_effort_timestamp * static_cast<double>(time_base.num) / static_cast<double>(time_base.den);
+}
+
+bool video_reader::next_frame()
+{
+    while(true)
+    {
+        // A precise seek leaves the target frame already decoded: return it without decoding again.
+        if(_has_pending_frame)
+            _has_pending_frame = false;
+        else if(!decode())
+            return false;
+
+        if(_decimation_interval <= 0)
+            return true;
+
+        // Decimation: frames before the next output slot are dropped here, before any conversion.
+        const auto frame_pts = _src_frame->best_effort_timestamp;
+        if(frame_pts == AV_NOPTS_VALUE)
+            return true;
+
+        if(_next_output_pts != AV_NOPTS_VALUE && frame_pts < _next_output_pts)
+            continue;
+
+        // Keep a steady output cadence, unless frames went missing for longer than a whole interval.
+        const bool resync = _next_output_pts == AV_NOPTS_VALUE || frame_pts - _next_output_pts >= _decimation_interval;
+        _next_output_pts = (resync ? frame_pts : _next_output_pts) + _decimation_interval;
+        return true;
+    }
+}
+
 bool video_reader::read(uint8_t** data, double* pts)
 {
     if(!_is_opened)
         return false;
 
-    if(auto r = av_read_frame(_format_ctx, _packet); r < 0)
+    if(!next_frame())
+        return false;
+
+    if(!convert(data, pts))
+        return false;
+
+    return true;
+}
+
+bool video_reader::read(frame& f)
+{
+    uint8_t* data = nullptr;
+    double pts = 0.0;
+    if(!read(&data, &pts))
+        return false;
+
+    return f.ref(get_output_frame(), pts);
+}
+
+int video_reader::read_batch(int n, int stride, uint8_t* buffer, double* pts)
+{
+    if(!_is_opened)
+        return 0;
+
+    if(n <= 0 || stride <= 0 || !buffer || _output.format == pixel_format::native)
     {
-        log_error("av_read_frame", vio::logger::get().err2str(r));
+        log_error("read_batch: invalid parameters:", "n:", n, "stride:", stride, "native output:", _output.format == pixel_format::native);
+        return 0;
+    }
+
+    const auto format = to_av_pixel_format(_output.format);
+    const auto frame_size_in_bytes = static_cast<size_t>(av_image_get_buffer_size(format, _output.width, _output.height, 1));
+
+    AVFrame* dst = av_frame_alloc();
+    if (!dst)
+    {
+        log_error("av_frame_alloc");
+        return 0;
+    }
+
+    int frames_read = 0;
+    while(frames_read < n)
+    {
+        // Frames in between two batch entries are decoded only, never converted.
+        // The stream may end in between: every exit goes through av_frame_free below.
+        bool has_frame = true;
+        for(int i = 0; i < stride - 1 && frames_read > 0 && has_frame; ++i)
+            has_frame = next_frame();
+
+        if(!has_frame || !next_frame())
+            break;
+
+        if(_decode_support == decode_support::HW && !copy_hw_frame(_src_frame, _tmp_frame))
+            break;
+
+        // sws_scale writes straight into the caller buffer slice: no intermediate frame, no extra copy.
+        if(!wrap_buffer(buffer + static_cast<size_t>(frames_read) * frame_size_in_bytes, frame_size_in_bytes, dst))
+            break;
+
+        const bool is_scaled = scale(_tmp_frame, dst);
+        av_frame_unref(dst);
+        if(!is_scaled)
+            break;
+
+        if(pts)
+            pts[frames_read] = get_frame_pts(_tmp_frame);
+
+        ++frames_read;
+    }
+
+    av_frame_free(&dst);
+    return frames_read;
+}
+
+bool video_reader::wrap_buffer(uint8_t* buffer, size_t size, AVFrame* dst)
+{
+    dst->format = to_av_pixel_format(_output.format);
+    dst->width  = _output.width;
+    dst->height = _output.height;
+
+    if (auto r = av_image_fill_arrays(dst->data, dst->linesize, buffer, static_cast<AVPixelFormat>(dst->format), dst->width, dst->height, 1); r < 0)
+    {
+        log_error("av_image_fill_arrays", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    // The caller owns the memory: the buffer reference is only there to satisfy the frame API, and never frees it.
+    if (dst->buf[0] = av_buffer_create(buffer, size, [](void*, uint8_t*){}, nullptr, 0); !dst->buf[0])
+    {
+        log_error("av_buffer_create");
+        return false;
+    }
+
+    return true;
+}
+
+AVFrame* video_reader::get_output_frame() const
+{
+    return _output.format == pixel_format::native ? _tmp_frame : _dst_frame;
+}
+
+bool video_reader::seek(std::chrono::steady_clock::duration position, seek_mode mode)
+{
+    if(!_is_opened)
+        return false;
+
+    if(position.count() < 0)
+    {
+        log_error("seek: invalid position");
+        return false;
+    }
+
+    // Not offset by the stream start time: the position is compared with the frame pts, which are not either.
+    const auto stream = _format_ctx->streams[_stream_index];
+    const auto position_us = std::chrono::duration_cast<std::chrono::microseconds>(position).count();
+    return seek_timestamp(av_rescale_q(position_us, AVRational{ 1, AV_TIME_BASE }, stream->time_base), mode);
+}
+
+bool video_reader::seek_frame(int frame_index, seek_mode mode)
+{
+    if(!_is_opened)
+        return false;
+
+    const auto stream = _format_ctx->streams[_stream_index];
+    const auto frame_rate = stream->avg_frame_rate;
+    if(frame_index < 0 || frame_rate.num <= 0 || frame_rate.den <= 0)
+    {
+        log_error("seek_frame: invalid frame index or unknown frame rate");
+        return false;
+    }
+
+    auto timestamp = av_rescale_q(frame_index, av_inv_q(frame_rate), stream->time_base);
+    if (stream->start_time != AV_NOPTS_VALUE)
+        timestamp += stream->start_time;
+
+    return seek_timestamp(timestamp, mode);
+}
+
+bool video_reader::seek_timestamp(int64_t timestamp, seek_mode mode)
+{
+    int r = 0;
+    if (const auto entry = _keyframe_index ? _keyframe_index->find(timestamp) : nullptr; entry)
+    {
+        // The index knows where the GOP starts: jump right onto it, so at most one GOP is decoded afterwards.
+        // Byte seeking is used where timestamp seeking is only approximate (same rule as ffplay).
+        const auto iformat = _format_ctx->iformat;
+        const bool seek_by_bytes = entry->pos >= 0
+            && !(iformat->flags & AVFMT_NO_BYTE_SEEK)
+            && (iformat->flags & AVFMT_TS_DISCONT)
+            && std::strcmp(iformat->name, "ogg") != 0;
+
+        if (seek_by_bytes)
+            r = av_seek_frame(_format_ctx, _stream_index, entry->pos, AVSEEK_FLAG_BYTE);
+        else
+            r = av_seek_frame(_format_ctx, _stream_index, entry->pts, AVSEEK_FLAG_BACKWARD);
+    }
+    else
+    {
+        // Land on the closest keyframe at or before the requested timestamp.
+        r = av_seek_frame(_format_ctx, _stream_index, timestamp, AVSEEK_FLAG_BACKWARD);
+    }
+
+    if (r < 0)
+    {
+        log_error("av_seek_frame", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    avcodec_flush_buffers(_codec_ctx);
+    _has_pending_frame = false;
+    _next_output_pts = AV_NOPTS_VALUE;
+
+    if(mode == seek_mode::keyframe)
+        return true;
+
+    // Decode forward from the keyframe, dropping frames before the target without converting them.
+    while(decode())
+    {
+        if(_src_frame->best_effort_timestamp == AV_NOPTS_VALUE || _src_frame->best_effort_timestamp >= timestamp)
+        {
+            _has_pending_frame = true;
+            return true;
+        }
+    }
+
+    log_error("seek: target position is past the end of the stream");
+    return false;
+}
+
+bool video_reader::set_frame_stride(int stride)
+{
+    if(!_is_opened)
+    {
+        log_error("Frame stride not set. Video path must be opened first.");
+        return false;
+    }
+
+    if(stride <= 0)
+    {
+        log_error("set_frame_stride: invalid stride:", stride);
+        return false;
+    }
+
+    if(stride == 1)
+    {
+        set_decimation_interval(0);
+        return true;
+    }
+
+    const auto stream = _format_ctx->streams[_stream_index];
+    const auto frame_rate = stream->avg_frame_rate;
+    if(frame_rate.num <= 0 || frame_rate.den <= 0)
+    {
+        log_error("set_frame_stride: unknown frame rate");
+        return false;
+    }
+
+    set_decimation_interval(av_rescale_q(stride, av_inv_q(frame_rate), stream->time_base));
+    return true;
+}
+
+bool video_reader::set_target_fps(double fps)
+{
+    if(!_is_opened)
+    {
+        log_error("Target FPS not set. Video path must be opened first.");
+        return false;
+    }
+
+    if(fps <= 0.0)
+    {
+        log_error("set_target_fps: invalid fps:", fps);
+        return false;
+    }
+
+    // Nothing to drop when the target rate is not lower than the source one.
+    if(auto source_fps = get_fps(); source_fps.has_value() && fps >= source_fps.value())
+    {
+        set_decimation_interval(0);
+        return true;
+    }
+
+    const auto time_base = _format_ctx->streams[_stream_index]->time_base;
+    const auto interval = std::llround(time_base.den / (fps * time_base.num));
+    set_decimation_interval(std::max<int64_t>(interval, 1));
+    return true;
+}
+
+void video_reader::set_decimation_interval(int64_t interval)
+{
+    _decimation_interval = interval;
+    _next_output_pts = AV_NOPTS_VALUE;
+    update_skip_frame();
+}
+
+bool video_reader::set_keyframes_only(bool enable)
+{
+    if(!_is_opened)
+    {
+        log_error("Keyframes only mode not set. Video path must be opened first.");
+        return false;
+    }
+
+    _keyframes_only = enable;
+    update_skip_frame();
+    return true;
+}
+
+bool video_reader::set_decoder_threads(int count, decoder_threading model)
+{
+    if(count < 0)
+    {
+        log_error("Decoder threads not set. Invalid count:", count);
+        return false;
+    }
+
+    _decoder_threads = count;
+    _decoder_threading = model;
+    return true;
+}
+
+bool video_reader::set_probe_options(const probe_options& options)
+{
+    // FFmpeg needs at least 32 bytes to probe the input format.
+    if((options.probesize != 0 && options.probesize < 32) || options.analyze_duration.count() < 0)
+    {
+        log_error("Probe options not set. Invalid probesize:", options.probesize, "analyze duration:", options.analyze_duration.count());
+        return false;
+    }
+
+    _probe_options = options;
+    return true;
+}
+
+bool video_reader::set_frame_pool_size(int max_buffers)
+{
+    if(max_buffers < 0)
+    {
+        log_error("Frame pool size not set. Invalid max buffers:", max_buffers);
+        return false;
+    }
+
+    _frame_pool->set_max_buffers(max_buffers);
+    return true;
+}
+
+void video_reader::set_decoder_thread_budget(int max_threads)
+{
+    thread_budget::get().set_max_threads(max_threads);
+}
+
+auto video_reader::get_decoder_threads_in_use() -> int
+{
+    return thread_budget::get().get_threads_in_use();
+}
+
+void video_reader::update_skip_frame()
+{
+    // Keyframes only: the decoder discards everything else.
+    // Decimation: non-reference frames are never needed to decode the frames that are kept, skip their decoding altogether.
+    if(_keyframes_only)
+        _codec_ctx->skip_frame = AVDISCARD_NONKEY;
+    else if(_decimation_interval > 0)
+        _codec_ctx->skip_frame = AVDISCARD_NONREF;
+    else
+        _codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+}
+
+bool video_reader::build_keyframe_index()
+{
+    if(!_is_opened)
+        return false;
+
+    auto index = std::make_unique<keyframe_index>();
+    const auto stream = _format_ctx->streams[_stream_index];
+    index->stream_index = _stream_index;
+    index->time_base_num = stream->time_base.num;
+    index->time_base_den = stream->time_base.den;
+    index->file_size = _format_ctx->pb ? avio_size(_format_ctx->pb) : -1;
+
+    const auto start_time = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    if (auto r = av_seek_frame(_format_ctx, _stream_index, start_time, AVSEEK_FLAG_BACKWARD); r < 0)
+    {
+        log_error("av_seek_frame", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    // Scan packets only: every other stream is discarded by the demuxer and nothing gets decoded.
+    std::vector<AVDiscard> discards;
+    for (unsigned int i = 0; i < _format_ctx->nb_streams; ++i)
+    {
+        discards.push_back(_format_ctx->streams[i]->discard);
+        if (static_cast<int>(i) != _stream_index)
+            _format_ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    int r = 0;
+    while ((r = av_read_frame(_format_ctx, _packet)) >= 0)
+    {
+        if (_packet->stream_index == _stream_index && (_packet->flags & AV_PKT_FLAG_KEY))
+        {
+            const auto pts = _packet->pts != AV_NOPTS_VALUE ? _packet->pts : _packet->dts;
+            index->entries.push_back({ pts, _packet->dts, _packet->pos });
+        }
+
         av_packet_unref(_packet);
+    }
+
+    for (unsigned int i = 0; i < _format_ctx->nb_streams; ++i)
+        _format_ctx->streams[i]->discard = discards[i];
+
+    if (r != AVERROR_EOF)
+    {
+        log_error("av_read_frame", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    index->sort();
+    _keyframe_index = std::move(index);
+    log_info("Keyframe index built:", _keyframe_index->entries.size(), "keyframes");
+
+    // Rewind, so that the next read() starts again from the first frame.
+    return seek_timestamp(start_time, seek_mode::keyframe);
+}
+
+bool video_reader::save_keyframe_index(const std::string& index_path) const
+{
+    if(!_keyframe_index)
+    {
+        log_error("Keyframe index not available. It must be built or loaded first.");
         return false;
     }
 
-    if(!decode(_packet))
+    return _keyframe_index->save(index_path);
+}
+
+bool video_reader::load_keyframe_index(const std::string& index_path)
+{
+    if(!_is_opened)
+    {
+        log_error("Keyframe index not loaded. Video path must be opened first.");
         return false;
+    }
 
-    if(!convert(data, pts))
+    auto index = std::make_unique<keyframe_index>();
+    if(!index->load(index_path))
         return false;
 
+    // Reject sidecars that do not belong to the opened input.
+    const auto stream = _format_ctx->streams[_stream_index];
+    const auto file_size = _format_ctx->pb ? avio_size(_format_ctx->pb) : -1;
+    if (index->stream_index != _stream_index
+        || index->time_base_num != stream->time_base.num
+        || index->time_base_den != stream->time_base.den
+        || (file_size >= 0 && index->file_size >= 0 && index->file_size != file_size))
+    {
+        log_error("Keyframe index does not match the opened input:", index_path);
+        return false;
+    }
+
+    _keyframe_index = std::move(index);
     return true;
 }
 
+auto video_reader::get_keyframe_count() const -> std::optional<int>
+{
+    if(!_keyframe_index)
+    {
+        log_error("Keyframe count not available. Keyframe index must be built or loaded first.");
+        return std::nullopt;
+    }
+
+    return std::make_optional(static_cast<int>(_keyframe_index->entries.size()));
+}
+
+auto video_reader::get_frame_pool_stats() const -> std::optional<frame_pool_stats>
+{
+    return std::make_optional(_frame_pool->get_stats());
+}
+
+auto video_reader::get_open_timings() const -> std::optional<open_timings>
+{
+    if(!_is_opened)
+    {
+        log_error("Open timings not available. Video path must be opened first.");
+        return std::nullopt;
+    }
+
+    return std::make_optional(_open_timings);
+}
+
+auto video_reader::get_decoder_threads() const -> std::optional<int>
+{
+    if(!_is_opened)
+    {
+        log_error("Decoder threads not available. Video path must be opened first.");
+        return std::nullopt;
+    }
+
+    return std::make_optional(_granted_threads);
+}
+
 bool video_reader::release()
 {
     if(!_is_opened)
         return false;
 
     log_info("Release video reader");
-    decode(nullptr);
 
     if(_sws_ctx)
         sws_freeContext(_sws_ctx);
@@ -467,6 +1374,9 @@ bool video_reader::release()
         avformat_free_context(_format_ctx);
     }
 
+    _custom_io.reset();
+    _mapped_file.reset();
+
     if (_options)
        av_dict_free(&_options);
 
@@ -482,6 +1392,9 @@ bool video_reader::release()
     if(_tmp_frame && _decode_support == decode_support::HW)
         av_frame_free(&_tmp_frame);
 
+    _keyframe_index.reset();
+    thread_budget::get().release(_granted_threads);
+
     init();
 
     if(_decode_support == decode_support::HW)
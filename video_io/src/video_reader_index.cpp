@@ -0,0 +1,139 @@
+#include "logger.hpp"
+#include "video_reader_index.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+/*
+Sidecar layout (native endianness):
+    magic[8] | version u32 | stream_index i32 | time_base num i32 | time_base den i32 | file_size i64 | count u64 | count * { pts i64, dts i64, pos i64 }
+*/
+
+namespace vio
+{
+namespace
+{
+constexpr char index_magic[8] = { 'V', 'I', 'O', 'K', 'F', 'I', 'D', 'X' };
+constexpr uint32_t index_version = 1;
+
+template<typename T>
+void write_value(std::ofstream& out, const T& value) { out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+template<typename T>
+bool read_value(std::ifstream& in, T& value) { return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T))); }
+}
+
+video_reader::keyframe_index::keyframe_index()
+{
+    reset();
+}
+
+bool video_reader::keyframe_index::save(const std::string& index_path) const
+{
+    std::ofstream out(index_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        log_error("Unable to create keyframe index file:", index_path);
+        return false;
+    }
+
+    out.write(index_magic, sizeof(index_magic));
+    write_value(out, index_version);
+    write_value(out, static_cast<int32_t>(stream_index));
+    write_value(out, static_cast<int32_t>(time_base_num));
+    write_value(out, static_cast<int32_t>(time_base_den));
+    write_value(out, file_size);
+    write_value(out, static_cast<uint64_t>(entries.size()));
+    out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(entry)));
+
+    if (!out)
+    {
+        log_error("Unable to write keyframe index file:", index_path);
+        return false;
+    }
+
+    return true;
+}
+
+bool video_reader::keyframe_index::load(const std::string& index_path)
+{
+    reset();
+
+    std::ifstream in(index_path, std::ios::binary);
+    if (!in)
+    {
+        log_error("Unable to open keyframe index file:", index_path);
+        return false;
+    }
+
+    char magic[sizeof(index_magic)] = {};
+    uint32_t version = 0;
+    int32_t stream = -1, tb_num = 0, tb_den = 0;
+    int64_t size = -1;
+    uint64_t count = 0;
+
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, index_magic, sizeof(magic)) != 0 || !read_value(in, version) || version != index_version)
+    {
+        log_error("Invalid keyframe index file:", index_path);
+        return false;
+    }
+
+    if (!read_value(in, stream) || !read_value(in, tb_num) || !read_value(in, tb_den) || !read_value(in, size) || !read_value(in, count))
+    {
+        log_error("Truncated keyframe index file:", index_path);
+        return false;
+    }
+
+    // The count comes from the file: checked against what is left of it before allocating.
+    const auto entries_begin = in.tellg();
+    in.seekg(0, std::ios::end);
+    const auto remaining = static_cast<uint64_t>(in.tellg() - entries_begin);
+    in.seekg(entries_begin);
+    if (!in || count > remaining / sizeof(entry))
+    {
+        log_error("Truncated keyframe index file:", index_path);
+        return false;
+    }
+
+    std::vector<entry> loaded_entries(count);
+    if (!in.read(reinterpret_cast<char*>(loaded_entries.data()), static_cast<std::streamsize>(count * sizeof(entry))))
+    {
+        log_error("Truncated keyframe index file:", index_path);
+        return false;
+    }
+
+    stream_index = stream;
+    time_base_num = tb_num;
+    time_base_den = tb_den;
+    file_size = size;
+    entries = std::move(loaded_entries);
+    return true;
+}
+
+const video_reader::keyframe_index::entry* video_reader::keyframe_index::find(int64_t timestamp) const
+{
+    // Last keyframe whose pts is not after the requested timestamp.
+    auto it = std::upper_bound(entries.begin(), entries.end(), timestamp, [](int64_t ts, const entry& e){ return ts < e.pts; });
+    if (it == entries.begin())
+        return nullptr;
+
+    return &*std::prev(it);
+}
+
+void video_reader::keyframe_index::sort()
+{
+    std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b){ return a.pts < b.pts; });
+}
+
+void video_reader::keyframe_index::reset()
+{
+    stream_index = -1;
+    time_base_num = 0;
+    time_base_den = 1;
+    file_size = -1;
+    entries.clear();
+}
+
+}
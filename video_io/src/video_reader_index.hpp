@@ -0,0 +1,35 @@
+#pragma once
+
+#include <video_io/video_reader.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace vio
+{
+struct video_reader::keyframe_index
+{
+    struct entry
+    {
+        int64_t pts;
+        int64_t dts;
+        int64_t pos;
+    };
+
+    explicit keyframe_index();
+
+    bool save(const std::string& index_path) const;
+    bool load(const std::string& index_path);
+    const entry* find(int64_t timestamp) const;
+    void sort();
+    void reset();
+
+    int stream_index;
+    int time_base_num;
+    int time_base_den;
+    int64_t file_size;
+    std::vector<entry> entries;
+};
+
+}
@@ -0,0 +1,243 @@
+#include "logger.hpp"
+#include "video_reader_io.hpp"
+
+extern "C"
+{
+#include <libavformat/avio.h>
+#include <libavutil/mem.h>
+}
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace vio
+{
+video_reader::custom_io::custom_io(const input_callbacks& callbacks)
+: callbacks{ callbacks }
+, avio_ctx{ nullptr }
+{
+}
+
+video_reader::custom_io::~custom_io()
+{
+    release();
+}
+
+bool video_reader::custom_io::init(int buffer_size)
+{
+    // The buffer belongs to the AVIOContext from now on: FFmpeg may reallocate it, hence av_malloc.
+    auto* buffer = static_cast<unsigned char*>(av_malloc(buffer_size));
+    if (!buffer)
+    {
+        log_error("av_malloc");
+        return false;
+    }
+
+    // Without a seek callback the input is a stream: demuxers only read it forward.
+    avio_ctx = avio_alloc_context(buffer, buffer_size, 0, this, &custom_io::read_packet, nullptr, callbacks.seek ? &custom_io::seek : nullptr);
+    if (!avio_ctx)
+    {
+        log_error("avio_alloc_context");
+        av_free(buffer);
+        return false;
+    }
+
+    return true;
+}
+
+void video_reader::custom_io::release()
+{
+    if (!avio_ctx)
+        return;
+
+    av_freep(&avio_ctx->buffer);
+    avio_context_free(&avio_ctx);
+}
+
+int video_reader::custom_io::read_packet(void* opaque, uint8_t* buffer, int size)
+{
+    auto* self = static_cast<custom_io*>(opaque);
+    const int count = self->callbacks.read(buffer, size);
+    if (count == 0)
+        return AVERROR_EOF;
+
+    return count < 0 ? AVERROR(EIO) : count;
+}
+
+int64_t video_reader::custom_io::seek(void* opaque, int64_t offset, int whence)
+{
+    auto* self = static_cast<custom_io*>(opaque);
+    if (whence & AVSEEK_SIZE)
+        return self->callbacks.size ? self->callbacks.size() : AVERROR(ENOSYS);
+
+    const auto position = self->callbacks.seek(offset, whence & ~AVSEEK_FORCE);
+    return position < 0 ? AVERROR(EIO) : position;
+}
+
+input_callbacks video_reader::custom_io::memory_input(const uint8_t* data, size_t size, const std::function<void(size_t)>& on_read)
+{
+    // The read position is shared by the read and seek callbacks.
+    auto position = std::make_shared<size_t>(0);
+
+    input_callbacks callbacks;
+    callbacks.read = [data, size, position, on_read](uint8_t* buffer, int buffer_size)
+    {
+        const size_t count = std::min(static_cast<size_t>(buffer_size), size - *position);
+        std::memcpy(buffer, data + *position, count);
+        *position += count;
+
+        if (on_read)
+            on_read(*position);
+
+        return static_cast<int>(count);
+    };
+
+    callbacks.seek = [size, position](int64_t offset, int whence) -> int64_t
+    {
+        int64_t origin = 0;
+        if (whence == SEEK_CUR)
+            origin = static_cast<int64_t>(*position);
+        else if (whence == SEEK_END)
+            origin = static_cast<int64_t>(size);
+
+        const int64_t target = origin + offset;
+        if (target < 0 || target > static_cast<int64_t>(size))
+            return -1;
+
+        *position = static_cast<size_t>(target);
+        return target;
+    };
+
+    callbacks.size = [size]{ return static_cast<int64_t>(size); };
+    return callbacks;
+}
+
+video_reader::mapped_file::mapped_file()
+: data{ nullptr }
+, size{ 0 }
+, advised_begin{ 0 }
+, advised_end{ 0 }
+{
+}
+
+video_reader::mapped_file::~mapped_file()
+{
+    release();
+}
+
+bool video_reader::mapped_file::open(const char* path)
+{
+    release();
+
+#if defined(_WIN32)
+    // The view keeps the mapping alive: both handles can be closed as soon as it is mapped.
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        log_error("Unable to open file:", path);
+        return false;
+    }
+
+    LARGE_INTEGER file_size = {};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    CloseHandle(file);
+    if (!mapping)
+    {
+        log_error("Unable to map file:", path);
+        return false;
+    }
+
+    data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!data)
+    {
+        log_error("MapViewOfFile failed:", path);
+        return false;
+    }
+
+    size = static_cast<size_t>(file_size.QuadPart);
+#else
+    // The mapping keeps the file alive: the descriptor can be closed as soon as it is mapped.
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        log_error("Unable to open file:", path);
+        return false;
+    }
+
+    struct stat file_stat = {};
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+        mapping = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        log_error("Unable to map file:", path);
+        return false;
+    }
+
+    data = static_cast<const uint8_t*>(mapping);
+    size = static_cast<size_t>(file_stat.st_size);
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    advise(0);
+#endif
+
+    return true;
+}
+
+void video_reader::mapped_file::release()
+{
+    if (!data)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<uint8_t*>(data), size);
+#endif
+
+    data = nullptr;
+    size = 0;
+    advised_begin = 0;
+    advised_end = 0;
+}
+
+input_callbacks video_reader::mapped_file::input()
+{
+    return custom_io::memory_input(data, size, [this](size_t position){ advise(position); });
+}
+
+void video_reader::mapped_file::advise(size_t position)
+{
+#if !defined(_WIN32)
+    // Ask for the next window once half of the current one is consumed, or when a seek left it.
+    const bool is_in_window = position >= advised_begin && position <= advised_end;
+    if (is_in_window && (position + read_ahead_size / 2 <= advised_end || advised_end == size))
+        return;
+
+    const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    advised_begin = position / page_size * page_size;
+    advised_end = std::min(size, position + read_ahead_size);
+    madvise(const_cast<uint8_t*>(data) + advised_begin, advised_end - advised_begin, MADV_WILLNEED);
+#endif
+}
+
+}
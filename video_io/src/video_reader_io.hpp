@@ -0,0 +1,56 @@
+#pragma once
+
+#include <video_io/video_reader.hpp>
+
+#include <functional>
+
+struct AVIOContext;
+
+namespace vio
+{
+/**
+ * AVIOContext reading through user callbacks instead of a file or URL.
+*/
+struct video_reader::custom_io
+{
+    static constexpr int default_buffer_size = 64 * 1024;
+
+    explicit custom_io(const input_callbacks& callbacks);
+    ~custom_io();
+
+    bool init(int buffer_size = default_buffer_size);
+    void release();
+
+    // on_read is called with the new read position after each read.
+    static input_callbacks memory_input(const uint8_t* data, size_t size, const std::function<void(size_t)>& on_read = {});
+    static int read_packet(void* opaque, uint8_t* buffer, int size);
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+
+    input_callbacks callbacks;
+    AVIOContext* avio_ctx;
+};
+
+/**
+ * Read-only memory mapping of a local file, read through custom_io::memory_input: no read() syscall per AVIO buffer.
+ * The read callback still copies from the mapping into the AVIO buffer, libavformat parses out of its own buffer.
+ * The kernel is asked to page in a window ahead of the read position.
+*/
+struct video_reader::mapped_file
+{
+    static constexpr size_t read_ahead_size = 8 * 1024 * 1024;
+
+    explicit mapped_file();
+    ~mapped_file();
+
+    bool open(const char* path);
+    void release();
+    input_callbacks input();
+    void advise(size_t position);
+
+    const uint8_t* data;
+    size_t size;
+    size_t advised_begin;
+    size_t advised_end;
+};
+
+}
@@ -0,0 +1,151 @@
+#include "logger.hpp"
+#include "video_reader_pool.hpp"
+
+extern "C"
+{
+#include <libavutil/buffer.h>
+#include <libavutil/mem.h>
+}
+
+#include <algorithm>
+
+namespace vio
+{
+video_reader::frame_pool::frame_pool()
+: stats{}
+, max_buffers{ 0 }
+, has_owner{ true }
+{
+}
+
+video_reader::frame_pool::~frame_pool()
+{
+    // Buffers still idle in the pools are freed here, the pools themselves once all their buffers are back.
+    for (auto& [size, p] : pools)
+        av_buffer_pool_uninit(&p.pool);
+}
+
+AVBufferRef* video_reader::frame_pool::get(size_t size)
+{
+    std::unique_lock g(lock);
+
+    auto it = pools.find(size);
+    if (it == pools.end())
+    {
+        AVBufferPool* pool = av_buffer_pool_init2(size, this, &frame_pool::alloc_buffer, nullptr);
+        if (!pool)
+        {
+            log_error("av_buffer_pool_init2");
+            return nullptr;
+        }
+
+        it = pools.emplace(size, size_pool{ pool, 0, 0 }).first;
+    }
+
+    auto& p = it->second;
+
+    // Every pooled buffer is in use and the pool is full: fall back to a plain allocation, freed on release.
+    if (max_buffers > 0 && p.outstanding == p.buffers && p.buffers >= max_buffers)
+    {
+        ++stats.unpooled;
+        g.unlock();
+        return av_buffer_alloc(size);
+    }
+
+    // The pool allocates through alloc_buffer when it has no idle buffer: that call counts the misses.
+    const auto misses = stats.misses;
+    AVBufferRef* pooled = av_buffer_pool_get(p.pool);
+    if (!pooled)
+    {
+        log_error("av_buffer_pool_get");
+        return nullptr;
+    }
+
+    if (stats.misses == misses)
+        ++stats.hits;
+
+    AVBufferRef* buffer = av_buffer_create(pooled->data, pooled->size, &frame_pool::release_buffer, pooled, 0);
+    if (!buffer)
+    {
+        log_error("av_buffer_create");
+        av_buffer_unref(&pooled);
+        return nullptr;
+    }
+
+    ++p.outstanding;
+    ++stats.outstanding;
+    stats.high_water = std::max(stats.high_water, stats.outstanding);
+    return buffer;
+}
+
+AVBufferRef* video_reader::frame_pool::alloc_buffer(void* opaque, size_t size)
+{
+    // Called by av_buffer_pool_get with the pool lock held by get().
+    auto* self = static_cast<frame_pool*>(opaque);
+    uint8_t* data = static_cast<uint8_t*>(av_malloc(size));
+    if (!data)
+        return nullptr;
+
+    AVBufferRef* buffer = av_buffer_create(data, size, av_buffer_default_free, self, 0);
+    if (!buffer)
+    {
+        av_free(data);
+        return nullptr;
+    }
+
+    ++self->pools[size].buffers;
+    ++self->stats.misses;
+    ++self->stats.pooled_buffers;
+    return buffer;
+}
+
+void video_reader::frame_pool::release_buffer(void* opaque, uint8_t*)
+{
+    auto* pooled = static_cast<AVBufferRef*>(opaque);
+    auto* self = static_cast<frame_pool*>(av_buffer_pool_buffer_get_opaque(pooled));
+    const size_t size = pooled->size;
+
+    // Back into its AVBufferPool, ready for the next get() of the same size.
+    av_buffer_unref(&pooled);
+
+    std::unique_lock g(self->lock);
+    --self->pools[size].outstanding;
+    --self->stats.outstanding;
+
+    const bool is_orphan = !self->has_owner && self->stats.outstanding == 0;
+    g.unlock();
+
+    if (is_orphan)
+        delete self;
+}
+
+void video_reader::frame_pool::set_max_buffers(int max_buffers)
+{
+    std::lock_guard g(lock);
+    this->max_buffers = std::max(max_buffers, 0);
+}
+
+frame_pool_stats video_reader::frame_pool::get_stats() const
+{
+    std::lock_guard g(lock);
+    return stats;
+}
+
+void video_reader::frame_pool::release_owner()
+{
+    std::unique_lock g(lock);
+    has_owner = false;
+
+    const bool is_orphan = stats.outstanding == 0;
+    g.unlock();
+
+    if (is_orphan)
+        delete this;
+}
+
+void video_reader::frame_pool_deleter::operator()(frame_pool* pool) const
+{
+    pool->release_owner();
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <video_io/video_reader.hpp>
+
+#include <map>
+#include <mutex>
+
+struct AVBufferRef;
+struct AVBufferPool;
+
+namespace vio
+{
+/**
+ * Destination frame buffers, one AVBufferPool per buffer size.
+ * Buffers handed out are wrapped so that the pool knows when a frame handle lets go of them; the wrapper
+ * keeps the pool alive until the last outstanding buffer is released, even after the video reader is destroyed.
+*/
+struct video_reader::frame_pool
+{
+    struct size_pool
+    {
+        AVBufferPool* pool;
+        int buffers;
+        int outstanding;
+    };
+
+    explicit frame_pool();
+    ~frame_pool();
+
+    AVBufferRef* get(size_t size);
+    void set_max_buffers(int max_buffers);
+    frame_pool_stats get_stats() const;
+    void release_owner();
+
+    static AVBufferRef* alloc_buffer(void* opaque, size_t size);
+    static void release_buffer(void* opaque, uint8_t* data);
+
+    mutable std::mutex lock;
+    std::map<size_t, size_pool> pools;
+    frame_pool_stats stats;
+    int max_buffers;
+    bool has_owner;
+};
+
+}
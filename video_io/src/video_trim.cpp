@@ -0,0 +1,851 @@
+#include <video_io/video_trim.hpp>
+#include "logger.hpp"
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <limits>
+
+namespace vio
+{
+namespace
+{
+// Size of the NAL unit length fields of H.264 (avcC) and HEVC (hvcC) packets, 0 for start codes or other codecs.
+int get_nal_length_size(const AVCodecParameters* codecpar)
+{
+    const uint8_t* extradata = codecpar->extradata;
+    if (codecpar->codec_id == AV_CODEC_ID_H264 && codecpar->extradata_size >= 7 && extradata[0] == 1)
+        return (extradata[4] & 0x03) + 1;
+
+    if (codecpar->codec_id == AV_CODEC_ID_HEVC && codecpar->extradata_size >= 23 && (extradata[0] || extradata[1] || extradata[2] > 1))
+        return (extradata[21] & 0x03) + 1;
+
+    return 0;
+}
+
+void append_nal_unit(std::vector<uint8_t>& out, const uint8_t* nal, size_t size, int nal_length_size)
+{
+    for (int i = nal_length_size - 1; i >= 0; --i)
+        out.push_back(static_cast<uint8_t>(size >> (8 * i)));
+
+    out.insert(out.end(), nal, nal + size);
+}
+
+// Parameter sets of the copied stream, in the packet format: length prefixed NAL units from avcC / hvcC, extradata as is otherwise
+// (start codes, MPEG-4 / MPEG-2 sequence headers).
+std::vector<uint8_t> get_parameter_sets(const AVCodecParameters* codecpar, int nal_length_size)
+{
+    const uint8_t* extradata = codecpar->extradata;
+    const size_t size = codecpar->extradata_size > 0 ? static_cast<size_t>(codecpar->extradata_size) : 0;
+    if (!extradata || size == 0)
+        return {};
+
+    if (nal_length_size == 0)
+        return std::vector<uint8_t>(extradata, extradata + size);
+
+    std::vector<uint8_t> out;
+    size_t pos = 0;
+    auto read_nal_units = [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (pos + 2 > size)
+                return false;
+
+            const size_t nal_size = (extradata[pos] << 8) | extradata[pos + 1];
+            pos += 2;
+            if (pos + nal_size > size)
+                return false;
+
+            append_nal_unit(out, extradata + pos, nal_size, nal_length_size);
+            pos += nal_size;
+        }
+
+        return true;
+    };
+
+    if (codecpar->codec_id == AV_CODEC_ID_H264)
+    {
+        // avcC: 5 bytes header, SPS count and SPS, PPS count and PPS.
+        pos = 5;
+        if (!read_nal_units(extradata[pos++] & 0x1f) || pos >= size || !read_nal_units(extradata[pos++]))
+            return {};
+    }
+    else
+    {
+        // hvcC: 22 bytes header, then arrays of VPS / SPS / PPS / SEI: type, count and NAL units.
+        pos = 22;
+        const size_t array_count = extradata[pos++];
+        for (size_t i = 0; i < array_count; ++i)
+        {
+            if (pos + 3 > size)
+                return {};
+
+            const size_t count = (extradata[pos + 1] << 8) | extradata[pos + 2];
+            pos += 3;
+            if (!read_nal_units(count))
+                return {};
+        }
+    }
+
+    return out;
+}
+
+// Sample entry allowing parameter sets in band that differ from the extradata ones (ISO/IEC 14496-15), when the muxer knows it.
+// 0 otherwise: the muxer default.
+uint32_t get_in_band_codec_tag(const AVOutputFormat* oformat, AVCodecID codec_id)
+{
+    uint32_t tag = 0;
+    if (codec_id == AV_CODEC_ID_H264)
+        tag = MKTAG('a', 'v', 'c', '3');
+    else if (codec_id == AV_CODEC_ID_HEVC)
+        tag = MKTAG('h', 'e', 'v', '1');
+
+    if (tag == 0 || !oformat->codec_tag || av_codec_get_id(oformat->codec_tag, tag) != codec_id)
+        return 0;
+
+    return tag;
+}
+
+bool replace_packet_data(AVPacket* packet, const std::vector<uint8_t>& data)
+{
+    AVPacket* tmp = av_packet_alloc();
+    if (!tmp)
+    {
+        log_error("av_packet_alloc");
+        return false;
+    }
+
+    if (auto r = av_new_packet(tmp, static_cast<int>(data.size())); r < 0)
+    {
+        log_error("av_new_packet", vio::logger::get().err2str(r));
+        av_packet_free(&tmp);
+        return false;
+    }
+
+    std::copy(data.begin(), data.end(), tmp->data);
+    av_packet_copy_props(tmp, packet);
+    av_packet_unref(packet);
+    av_packet_move_ref(packet, tmp);
+    av_packet_free(&tmp);
+    return true;
+}
+
+// Encoders without global header emit start code prefixed NAL units, the copied packets use length prefixes.
+bool to_length_prefixed(AVPacket* packet, int nal_length_size)
+{
+    const uint8_t* data = packet->data;
+    const size_t size = packet->size;
+    const bool has_start_code = size >= 3 && data[0] == 0 && data[1] == 0 && (data[2] == 1 || (size >= 4 && data[2] == 0 && data[3] == 1));
+    if (!has_start_code)
+        return true;
+
+    // Offsets of the NAL units, right after each 00 00 01 start code.
+    std::vector<size_t> nal_offsets;
+    for (size_t i = 0; i + 2 < size; ++i)
+    {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+        {
+            nal_offsets.push_back(i + 3);
+            i += 2;
+        }
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(size + nal_offsets.size() * nal_length_size);
+    for (size_t i = 0; i < nal_offsets.size(); ++i)
+    {
+        // A NAL unit never ends with a zero byte: trailing zeros belong to the next 4 bytes start code.
+        size_t end = i + 1 < nal_offsets.size() ? nal_offsets[i + 1] - 3 : size;
+        while (end > nal_offsets[i] && data[end - 1] == 0)
+            --end;
+
+        append_nal_unit(out, data + nal_offsets[i], end - nal_offsets[i], nal_length_size);
+    }
+
+    return replace_packet_data(packet, out);
+}
+
+/**
+ * Decodes the boundary GOPs of a smart cut and re-encodes the frames inside the cut with the codec, size, pixel format
+ * and bit rate of the input stream, as packets that can be spliced with the copied ones.
+*/
+struct boundary_encoder
+{
+    using packet_writer = std::function<bool(AVPacket*)>;
+
+    ~boundary_encoder()
+    {
+        if (encoder_ctx)
+            avcodec_free_context(&encoder_ctx);
+
+        if (decoder_ctx)
+            avcodec_free_context(&decoder_ctx);
+
+        if (frame)
+            av_frame_free(&frame);
+
+        if (encoded)
+            av_packet_free(&encoded);
+    }
+
+    bool open_decoder(AVFormatContext* input_ctx, int stream_index, int64_t decoding_delay)
+    {
+        stream = input_ctx->streams[stream_index];
+        frame_rate = av_guess_frame_rate(input_ctx, input_ctx->streams[stream_index], nullptr);
+        // Streams without a bit rate of their own: the container average is close enough for the few re-encoded frames.
+        bit_rate = stream->codecpar->bit_rate > 0 ? stream->codecpar->bit_rate : input_ctx->bit_rate;
+        nal_length_size = get_nal_length_size(stream->codecpar);
+        parameter_sets = get_parameter_sets(stream->codecpar, nal_length_size);
+        dts_shift = decoding_delay;
+
+        const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (!codec)
+        {
+            log_error("Smart cut: no decoder for", avcodec_get_name(stream->codecpar->codec_id));
+            return false;
+        }
+
+        if (decoder_ctx = avcodec_alloc_context3(codec); !decoder_ctx)
+        {
+            log_error("avcodec_alloc_context3");
+            return false;
+        }
+
+        if (auto r = avcodec_parameters_to_context(decoder_ctx, stream->codecpar); r < 0)
+        {
+            log_error("avcodec_parameters_to_context", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        decoder_ctx->pkt_timebase = stream->time_base;
+        if (auto r = avcodec_open2(decoder_ctx, codec, nullptr); r < 0)
+        {
+            log_error("avcodec_open2", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        if (frame = av_frame_alloc(); !frame)
+        {
+            log_error("av_frame_alloc");
+            return false;
+        }
+
+        if (encoded = av_packet_alloc(); !encoded)
+        {
+            log_error("av_packet_alloc");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Frames with pts (stream time base) in [begin_ts, end_ts) are re-encoded.
+    void begin_segment(int64_t begin_ts, int64_t end_ts)
+    {
+        segment_begin = begin_ts;
+        segment_end = end_ts;
+        encoded_frames = 0;
+        is_past_end = false;
+    }
+
+    bool decode(const AVPacket* packet, const packet_writer& write)
+    {
+        if (auto r = avcodec_send_packet(decoder_ctx, packet); r < 0 && r != AVERROR_EOF)
+        {
+            log_error("avcodec_send_packet", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        while (true)
+        {
+            if (auto r = avcodec_receive_frame(decoder_ctx, frame); r < 0)
+            {
+                if (r == AVERROR(EAGAIN) || r == AVERROR_EOF)
+                    return true;
+
+                log_error("avcodec_receive_frame", vio::logger::get().err2str(r));
+                return false;
+            }
+
+            const int64_t pts = frame->best_effort_timestamp;
+            is_past_end = is_past_end || (pts != AV_NOPTS_VALUE && pts >= segment_end);
+
+            const bool is_encoded = pts != AV_NOPTS_VALUE && pts >= segment_begin && pts < segment_end;
+            const bool is_written = !is_encoded || encode(frame, pts, write);
+            av_frame_unref(frame);
+            if (!is_written)
+                return false;
+        }
+    }
+
+    // Drains the decoder and the encoder. The decoder is reused by the next segment, the encoder is not.
+    bool end_segment(const packet_writer& write)
+    {
+        bool is_ended = decode(nullptr, write);
+        avcodec_flush_buffers(decoder_ctx);
+
+        if (encoder_ctx)
+        {
+            if (auto r = avcodec_send_frame(encoder_ctx, nullptr); r < 0)
+            {
+                log_error("avcodec_send_frame", vio::logger::get().err2str(r));
+                is_ended = false;
+            }
+
+            is_ended = receive_packets(write) && is_ended;
+            avcodec_free_context(&encoder_ctx);
+        }
+
+        return is_ended;
+    }
+
+    bool prepend_parameter_sets(AVPacket* packet) const
+    {
+        if (parameter_sets.empty())
+            return true;
+
+        std::vector<uint8_t> data(parameter_sets);
+        data.insert(data.end(), packet->data, packet->data + packet->size);
+        return replace_packet_data(packet, data);
+    }
+
+    bool open_encoder(const AVFrame* f)
+    {
+        const AVCodec* codec = avcodec_find_encoder(stream->codecpar->codec_id);
+        if (!codec)
+        {
+            log_error("Smart cut: no encoder for", avcodec_get_name(stream->codecpar->codec_id));
+            return false;
+        }
+
+        if (encoder_ctx = avcodec_alloc_context3(codec); !encoder_ctx)
+        {
+            log_error("avcodec_alloc_context3");
+            return false;
+        }
+
+        encoder_ctx->width = f->width;
+        encoder_ctx->height = f->height;
+        encoder_ctx->pix_fmt = static_cast<AVPixelFormat>(f->format);
+        encoder_ctx->sample_aspect_ratio = f->sample_aspect_ratio;
+        encoder_ctx->color_range = f->color_range;
+        encoder_ctx->color_primaries = f->color_primaries;
+        encoder_ctx->color_trc = f->color_trc;
+        encoder_ctx->colorspace = f->colorspace;
+        encoder_ctx->time_base = stream->time_base;
+        encoder_ctx->framerate = frame_rate;
+        encoder_ctx->bit_rate = bit_rate;
+        encoder_ctx->profile = stream->codecpar->profile;
+        encoder_ctx->thread_count = 0;
+
+        // A boundary is at most one input GOP: a single keyframe at its start. No B-frames, so dts == pts before the shift.
+        encoder_ctx->gop_size = 600;
+        encoder_ctx->max_b_frames = 0;
+
+        // No AV_CODEC_FLAG_GLOBAL_HEADER: each boundary carries its parameter sets in band (avc3 / hev1 in MP4),
+        // the container keeps the copied ones.
+        if (auto r = avcodec_open2(encoder_ctx, codec, nullptr); r < 0)
+        {
+            log_error("avcodec_open2", avcodec_get_name(stream->codecpar->codec_id), vio::logger::get().err2str(r));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool encode(AVFrame* f, int64_t pts, const packet_writer& write)
+    {
+        if (!encoder_ctx && !open_encoder(f))
+            return false;
+
+        f->pts = pts;
+        f->pict_type = AV_PICTURE_TYPE_NONE;
+        if (auto r = avcodec_send_frame(encoder_ctx, f); r < 0)
+        {
+            log_error("avcodec_send_frame", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        ++encoded_frames;
+        return receive_packets(write);
+    }
+
+    bool receive_packets(const packet_writer& write)
+    {
+        while (true)
+        {
+            if (auto r = avcodec_receive_packet(encoder_ctx, encoded); r < 0)
+            {
+                if (r == AVERROR(EAGAIN) || r == AVERROR_EOF)
+                    return true;
+
+                log_error("avcodec_receive_packet", vio::logger::get().err2str(r));
+                return false;
+            }
+
+            if (nal_length_size > 0 && !to_length_prefixed(encoded, nal_length_size))
+                return false;
+
+            // Same decoding delay as the copied packets, so that dts keeps increasing across the splice points.
+            if (encoded->dts != AV_NOPTS_VALUE)
+                encoded->dts -= dts_shift;
+
+            if (!write(encoded))
+                return false;
+        }
+    }
+
+    const AVStream* stream = nullptr;
+    AVCodecContext* decoder_ctx = nullptr;
+    AVCodecContext* encoder_ctx = nullptr;
+    AVFrame* frame = nullptr;
+    AVPacket* encoded = nullptr;
+
+    AVRational frame_rate = { 0, 1 };
+    int64_t bit_rate = 0;
+    int nal_length_size = 0;
+    std::vector<uint8_t> parameter_sets;
+    int64_t dts_shift = 0;
+
+    int64_t segment_begin = 0;
+    int64_t segment_end = 0;
+    int encoded_frames = 0;
+    bool is_past_end = false;
+};
+
+/**
+ * Input and output format contexts of a stream copy, with the mapping from input to output stream indices (-1: dropped).
+*/
+struct remuxer
+{
+    ~remuxer()
+    {
+        if (packet)
+            av_packet_free(&packet);
+
+        if (input_ctx)
+            avformat_close_input(&input_ctx);
+
+        if (output_ctx)
+        {
+            if (!(output_ctx->oformat->flags & AVFMT_NOFILE))
+                avio_closep(&output_ctx->pb);
+
+            avformat_free_context(output_ctx);
+        }
+    }
+
+    bool open_input(const std::string& input_path)
+    {
+        if (auto r = avformat_open_input(&input_ctx, input_path.c_str(), nullptr, nullptr); r < 0)
+        {
+            log_error("avformat_open_input", input_path, vio::logger::get().err2str(r));
+            return false;
+        }
+
+        if (auto r = avformat_find_stream_info(input_ctx, nullptr); r < 0)
+        {
+            log_error("avformat_find_stream_info", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        if (video_stream = av_find_best_stream(input_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0); video_stream < 0)
+        {
+            log_error("av_find_best_stream", "No video stream in:", input_path);
+            return false;
+        }
+
+        if (packet = av_packet_alloc(); !packet)
+        {
+            log_error("av_packet_alloc");
+            return false;
+        }
+
+        return true;
+    }
+
+    // in_band_parameter_sets: the video packets carry parameter sets that differ from the extradata ones (smart cut).
+    bool open_output(const std::string& output_path, bool in_band_parameter_sets = false)
+    {
+        if (auto r = avformat_alloc_output_context2(&output_ctx, nullptr, nullptr, output_path.c_str()); r < 0)
+        {
+            log_error("avformat_alloc_output_context2", output_path, vio::logger::get().err2str(r));
+            return false;
+        }
+
+        for (unsigned int i = 0; i < input_ctx->nb_streams; ++i)
+        {
+            const AVCodecParameters* codecpar = input_ctx->streams[i]->codecpar;
+            const bool is_copied = codecpar->codec_type == AVMEDIA_TYPE_VIDEO || codecpar->codec_type == AVMEDIA_TYPE_AUDIO
+                || codecpar->codec_type == AVMEDIA_TYPE_SUBTITLE;
+
+            // Only the selected video stream: secondary video streams are usually cover art or thumbnails.
+            if (!is_copied || (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && static_cast<int>(i) != video_stream))
+            {
+                stream_mapping.push_back(-1);
+                continue;
+            }
+
+            AVStream* stream = avformat_new_stream(output_ctx, nullptr);
+            if (!stream)
+            {
+                log_error("avformat_new_stream");
+                return false;
+            }
+
+            if (auto r = avcodec_parameters_copy(stream->codecpar, codecpar); r < 0)
+            {
+                log_error("avcodec_parameters_copy", vio::logger::get().err2str(r));
+                return false;
+            }
+
+            // Codec tags are container specific, let the muxer pick its own.
+            stream->codecpar->codec_tag = 0;
+            stream->time_base = input_ctx->streams[i]->time_base;
+
+            // avc1 / hvc1 require the parameter sets of the sample entry: avc3 / hev1 also allow in band ones.
+            if (in_band_parameter_sets && codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+                stream->codecpar->codec_tag = get_in_band_codec_tag(output_ctx->oformat, codecpar->codec_id);
+            stream_mapping.push_back(stream->index);
+        }
+
+        if (!(output_ctx->oformat->flags & AVFMT_NOFILE))
+        {
+            if (auto r = avio_open(&output_ctx->pb, output_path.c_str(), AVIO_FLAG_WRITE); r < 0)
+            {
+                log_error("avio_open", output_path, vio::logger::get().err2str(r));
+                return false;
+            }
+        }
+
+        if (auto r = avformat_write_header(output_ctx, nullptr); r < 0)
+        {
+            log_error("avformat_write_header", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Timestamps relative to the start of the input, in AV_TIME_BASE units.
+    int64_t to_time_us(int64_t ts, const AVStream* stream) const
+    {
+        const int64_t input_start = input_ctx->start_time != AV_NOPTS_VALUE ? input_ctx->start_time : 0;
+        return av_rescale_q(ts, stream->time_base, AV_TIME_BASE_Q) - input_start;
+    }
+
+    int64_t from_time_us(int64_t time_us, const AVStream* stream) const
+    {
+        const int64_t input_start = input_ctx->start_time != AV_NOPTS_VALUE ? input_ctx->start_time : 0;
+        return av_rescale_q(time_us + input_start, AV_TIME_BASE_Q, stream->time_base);
+    }
+
+    bool seek(int64_t time_us)
+    {
+        // Backward: lands on the keyframe at or before time_us, the first video packet read is decodable.
+        const AVStream* stream = input_ctx->streams[video_stream];
+        if (auto r = av_seek_frame(input_ctx, video_stream, from_time_us(time_us, stream), AVSEEK_FLAG_BACKWARD); r < 0)
+        {
+            log_error("av_seek_frame", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Next packet of a copied stream, with its output stream index and time. < 0 at the end of the input or on error.
+    int read_packet(int* out_index, int64_t* time_us)
+    {
+        while (true)
+        {
+            if (auto r = av_read_frame(input_ctx, packet); r < 0)
+            {
+                if (r != AVERROR_EOF)
+                    log_error("av_read_frame", vio::logger::get().err2str(r));
+
+                return r;
+            }
+
+            const int in_index = packet->stream_index;
+            const int64_t ts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            *out_index = in_index < static_cast<int>(stream_mapping.size()) ? stream_mapping[in_index] : -1;
+            if (*out_index < 0 || ts == AV_NOPTS_VALUE)
+            {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            *time_us = to_time_us(ts, input_ctx->streams[in_index]);
+            return 0;
+        }
+    }
+
+    bool copy_packets(int64_t start_us, int64_t end_us)
+    {
+        if (start_us > 0 && !seek(start_us))
+            return false;
+
+        // Set by the first video keyframe when trimming, every stream is shifted by the same amount to stay in sync.
+        int64_t cut_start_us = start_us > 0 ? AV_NOPTS_VALUE : 0;
+
+        int out_index = -1;
+        int64_t time_us = 0;
+        while (true)
+        {
+            if (auto r = read_packet(&out_index, &time_us); r < 0)
+            {
+                if (r == AVERROR_EOF)
+                    break;
+
+                return false;
+            }
+
+            const AVStream* in_stream = input_ctx->streams[packet->stream_index];
+            const bool is_video_keyframe = packet->stream_index == video_stream && (packet->flags & AV_PKT_FLAG_KEY);
+
+            if (cut_start_us == AV_NOPTS_VALUE && is_video_keyframe)
+                cut_start_us = time_us;
+
+            // End on a keyframe: the GOP containing end is copied entirely.
+            if (is_video_keyframe && time_us >= end_us)
+            {
+                av_packet_unref(packet);
+                break;
+            }
+
+            // Before the cut: packets read since the seek point, or leading frames referencing the previous GOP.
+            if (cut_start_us == AV_NOPTS_VALUE || time_us < cut_start_us)
+            {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            if (!write_packet(packet, in_stream, out_index, cut_start_us))
+                return false;
+        }
+
+        return write_trailer();
+    }
+
+    /**
+     * Frame accurate cut: the partial GOPs at both ends are decoded and re-encoded, the GOPs in between are copied.
+     *   head:   frames in [start, first keyframe after start), decoded from the keyframe before start.
+     *   middle: packets from the first keyframe after start to the last keyframe before end, copied.
+     *   tail:   frames in [last keyframe before end, end), decoded from that keyframe.
+     * Without any keyframe inside the range the whole range is re-encoded. Closed GOPs are assumed: leading frames of
+     * an open GOP reference the previous GOP and are dropped where copied packets resume.
+    */
+    bool smart_copy(int64_t start_us, int64_t end_us)
+    {
+        const AVStream* video = input_ctx->streams[video_stream];
+        const int out_video = stream_mapping[video_stream];
+
+        // Last keyframe at or before end, the tail starts there. Its pts - dts is the decoding delay of the copied packets.
+        int out_index = -1;
+        int64_t time_us = 0;
+        int64_t tail_key_us = AV_NOPTS_VALUE;
+        int64_t dts_shift = 0;
+
+        if (!seek(end_us))
+            return false;
+
+        while (tail_key_us == AV_NOPTS_VALUE && read_packet(&out_index, &time_us) >= 0)
+        {
+            if (packet->stream_index == video_stream)
+            {
+                tail_key_us = time_us;
+                if (packet->pts != AV_NOPTS_VALUE && packet->dts != AV_NOPTS_VALUE)
+                    dts_shift = std::max<int64_t>(packet->pts - packet->dts, 0);
+            }
+
+            av_packet_unref(packet);
+        }
+
+        if (tail_key_us == AV_NOPTS_VALUE)
+        {
+            log_error("Smart cut: no video keyframe before end (us):", end_us);
+            return false;
+        }
+
+        if (!seek(start_us) || !boundary.open_decoder(input_ctx, video_stream, dts_shift))
+            return false;
+
+        auto write_encoded = [this, video, out_video, start_us](AVPacket* p)
+        {
+            return write_packet(p, video, out_video, start_us);
+        };
+
+        enum class cut_phase { head, middle, tail, done };
+        cut_phase phase = cut_phase::head;
+        int64_t middle_start_us = AV_NOPTS_VALUE;
+        const int64_t end_ts = from_time_us(end_us, video);
+        boundary.begin_segment(from_time_us(start_us, video), end_ts);
+
+        while (true)
+        {
+            if (auto r = read_packet(&out_index, &time_us); r < 0)
+            {
+                if (r == AVERROR_EOF)
+                    break;
+
+                return false;
+            }
+
+            if (phase == cut_phase::done && time_us >= end_us)
+            {
+                av_packet_unref(packet);
+                break;
+            }
+
+            // Other streams are copied as is over the exact range.
+            if (packet->stream_index != video_stream)
+            {
+                if (time_us < start_us || time_us >= end_us)
+                {
+                    av_packet_unref(packet);
+                    continue;
+                }
+
+                if (!write_packet(packet, input_ctx->streams[packet->stream_index], out_index, start_us))
+                    return false;
+
+                continue;
+            }
+
+            const cut_phase previous_phase = phase;
+            const bool is_keyframe = packet->flags & AV_PKT_FLAG_KEY;
+            const bool is_head_end = phase == cut_phase::head && ((is_keyframe && time_us >= start_us) || boundary.is_past_end);
+            const bool is_tail_end = phase == cut_phase::tail && ((is_keyframe && time_us > tail_key_us) || boundary.is_past_end);
+
+            if (is_head_end || is_tail_end)
+            {
+                const bool is_head_encoded = boundary.encoded_frames > 0;
+                if (!boundary.end_segment(write_encoded))
+                    return false;
+
+                phase = cut_phase::done;
+                if (is_head_end && is_keyframe && time_us < end_us)
+                {
+                    phase = time_us >= tail_key_us ? cut_phase::tail : cut_phase::middle;
+                    middle_start_us = time_us;
+
+                    // Copied packets resume after re-encoded ones carrying their own parameter sets: send the original ones again.
+                    if (phase == cut_phase::middle && is_head_encoded && !boundary.prepend_parameter_sets(packet))
+                        return false;
+                }
+            }
+            else if (phase == cut_phase::middle && is_keyframe && time_us >= tail_key_us)
+            {
+                // Ending on a keyframe leaves nothing to re-encode.
+                phase = time_us >= end_us ? cut_phase::done : cut_phase::tail;
+            }
+
+            if (phase == cut_phase::tail && previous_phase != cut_phase::tail)
+                boundary.begin_segment(packet->pts, end_ts);
+
+            if (phase == cut_phase::middle && time_us >= middle_start_us)
+            {
+                if (!write_packet(packet, video, out_video, start_us))
+                    return false;
+
+                continue;
+            }
+
+            const bool is_decoded = phase == cut_phase::head || phase == cut_phase::tail ? boundary.decode(packet, write_encoded) : true;
+            av_packet_unref(packet);
+            if (!is_decoded)
+                return false;
+        }
+
+        if ((phase == cut_phase::head || phase == cut_phase::tail) && !boundary.end_segment(write_encoded))
+            return false;
+
+        return write_trailer();
+    }
+
+    bool write_packet(AVPacket* p, const AVStream* in_stream, int out_index, int64_t cut_start_us)
+    {
+        const AVStream* out_stream = output_ctx->streams[out_index];
+
+        const int64_t offset = from_time_us(cut_start_us, in_stream);
+        if (p->pts != AV_NOPTS_VALUE)
+            p->pts -= offset;
+        if (p->dts != AV_NOPTS_VALUE)
+            p->dts -= offset;
+
+        av_packet_rescale_ts(p, in_stream->time_base, out_stream->time_base);
+        p->stream_index = out_index;
+        p->pos = -1;
+
+        // av_interleaved_write_frame() takes ownership of the packet contents and resets it.
+        if (auto r = av_interleaved_write_frame(output_ctx, p); r < 0)
+        {
+            log_error("av_interleaved_write_frame", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool write_trailer()
+    {
+        if (auto r = av_write_trailer(output_ctx); r < 0)
+        {
+            log_error("av_write_trailer", vio::logger::get().err2str(r));
+            return false;
+        }
+
+        return true;
+    }
+
+    AVFormatContext* input_ctx = nullptr;
+    AVFormatContext* output_ctx = nullptr;
+    AVPacket* packet = nullptr;
+    std::vector<int> stream_mapping;
+    int video_stream = -1;
+    boundary_encoder boundary;
+};
+
+int64_t to_microseconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+}
+
+bool remux(const std::string& input_path, const std::string& output_path)
+{
+    log_info("Remuxing:", input_path, "to:", output_path);
+
+    remuxer r;
+    return r.open_input(input_path) && r.open_output(output_path) && r.copy_packets(0, std::numeric_limits<int64_t>::max());
+}
+
+bool trim(const std::string& input_path, const std::string& output_path,
+    std::chrono::steady_clock::duration start, std::chrono::steady_clock::duration end, trim_mode mode)
+{
+    const int64_t start_us = to_microseconds(start);
+    const int64_t end_us = to_microseconds(end);
+    if (start_us < 0 || end_us <= start_us)
+    {
+        log_error("trim: invalid range:", "start (us):", start_us, "end (us):", end_us);
+        return false;
+    }
+
+    log_info("Trimming:", input_path, "to:", output_path, "start (us):", start_us, "end (us):", end_us,
+        "mode:", mode == trim_mode::smart ? "smart" : "keyframe");
+
+    remuxer r;
+    if (!r.open_input(input_path) || !r.open_output(output_path, mode == trim_mode::smart))
+        return false;
+
+    return mode == trim_mode::smart ? r.smart_copy(start_us, end_us) : r.copy_packets(start_us, end_us);
+}
+
+}
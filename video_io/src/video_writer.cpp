@@ -1,5 +1,7 @@
 #include <video_io/video_writer.hpp>
 #include "logger.hpp"
+#include "pixel_format.hpp"
+#include "video_writer_sink.hpp"
 
 extern "C"
 {
@@ -20,6 +22,8 @@ namespace vio
 {
 video_writer::video_writer() noexcept
 : _is_opened { false }
+, _time_base_num { 0 }
+, _time_base_den { 0 }
 {
     init(); 
     av_log_set_level(0);
@@ -44,6 +48,13 @@ void video_writer::init()
     _packet = nullptr;
     _sws_ctx = nullptr;
     _format_ctx = nullptr;
+
+    _segments = {};
+    _segment_path.clear();
+    _segment_index = 0;
+    _segment_boundary_pts = AV_NOPTS_VALUE;
+    _segment_start_dts = AV_NOPTS_VALUE;
+    _segment_splits.clear();
 }
 
 bool video_writer::open(const std::string& video_path, int width, int height, const int fps)
@@ -70,22 +81,226 @@ bool video_writer::open(const std::string& video_path, int width, int height, co
         }
     }
 
-    const AVCodec* codec = avcodec_find_encoder(_format_ctx->oformat->video_codec);
-    if (!codec)
+    if (!init_stream(width, height, fps))
+        return false;
+
+    if (!(_format_ctx->oformat->flags & AVFMT_NOFILE)) 
+    {
+        if (auto r = avio_open(&_format_ctx->pb, video_path.c_str(), AVIO_FLAG_WRITE); r < 0) 
+        {
+            log_error("avio_open", vio::logger::get().err2str(r));
+            return false;
+        }
+    }
+
+    return write_header(nullptr);
+}
+
+bool video_writer::open(const output_sink& sink, int width, int height, const int fps)
+{
+    if(width <= 0 || height <= 0 || fps <= 0 || sink.buffer_size <= 0 || !sink.write)
+    {
+        log_error("open: invalid parameters:", "width:", width, "height:", height, "fps:", fps, "buffer size:", sink.buffer_size);
+        return false;
+    }
+
+    std::lock_guard lock(_open_mutex);
+    release();
+
+    log_info("Opening output sink, format:", sink.format, "width:", width, "height:", height, "fps:", fps);
+
+    if (auto r = avformat_alloc_output_context2(&_format_ctx, nullptr, sink.format.c_str(), nullptr); r < 0)
     {
-        log_error("Could not find encoder for:", avcodec_get_name(_output_format->video_codec));
+        log_error("avformat_alloc_output_context2", sink.format, vio::logger::get().err2str(r));
         return false;
     }
 
+    if (!init_stream(width, height, fps))
+        return false;
+
+    if (_sink_io = std::make_unique<sink_io>(sink); !_sink_io->init())
+    {
+        log_error("Unable to initialize output sink");
+        return false;
+    }
+
+    // Custom IO: the format context never closes the AVIOContext, _sink_io frees it.
+    _format_ctx->pb = _sink_io->avio_ctx;
+    _format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    AVDictionary* options = nullptr;
+    if (sink.fragmented)
+    {
+        // empty_moov: the header is written upfront, then each keyframe starts a new fragment pushed to the sink.
+        if (auto r = av_dict_set(&options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0); r < 0)
+        {
+            log_error("av_dict_set", vio::logger::get().err2str(r));
+            return false;
+        }
+    }
+
+    const bool is_opened = write_header(&options);
+    av_dict_free(&options);
+    return is_opened;
+}
+
+bool video_writer::open(const segment_spec& segments, int width, int height, const int fps)
+{
+    if(width <= 0 || height <= 0 || fps <= 0 || segments.pattern.empty() || segments.duration.count() <= 0)
+    {
+        log_error("open: invalid parameters:", "width:", width, "height:", height, "fps:", fps,
+            "pattern:", segments.pattern, "segment duration (ms):", segments.duration.count());
+        return false;
+    }
+
+    std::lock_guard lock(_open_mutex);
+    release();
+
+    log_info("Opening segments:", segments.pattern, "width:", width, "height:", height, "fps:", fps,
+        "segment duration (ms):", segments.duration.count());
+
+    _segments = segments;
+    if (!open_segment())
+        return false;
+
+    if (!init_stream(width, height, fps))
+        return false;
+
+    if (auto r = avio_open(&_format_ctx->pb, _segment_path.c_str(), AVIO_FLAG_WRITE); r < 0)
+    {
+        log_error("avio_open", _segment_path, vio::logger::get().err2str(r));
+        return false;
+    }
+
+    return write_header(nullptr);
+}
+
+bool video_writer::set_input(const input_spec& input)
+{
+    if(input.width < 0 || input.height < 0)
+    {
+        log_error("Input not set. Invalid size:", "width:", input.width, "height:", input.height);
+        return false;
+    }
+
+    _input = input;
+    return true;
+}
+
+bool video_writer::set_encoder(const encoder_spec& encoder)
+{
+    if(encoder.gop_size < 0 || encoder.threads < 0 || encoder.bit_rate < 0 || encoder.max_bit_rate < 0 || encoder.rc_buffer_size < 0)
+    {
+        log_error("Encoder not set. Invalid parameters:", "gop size:", encoder.gop_size, "threads:", encoder.threads,
+            "bit rate:", encoder.bit_rate, "max bit rate:", encoder.max_bit_rate, "rc buffer size:", encoder.rc_buffer_size);
+        return false;
+    }
+
+    _encoder = encoder;
+    return true;
+}
+
+bool video_writer::set_time_base(int num, int den)
+{
+    if((num <= 0 || den <= 0) && (num != 0 || den != 0))
+    {
+        log_error("Time base not set. Invalid parameters:", "num:", num, "den:", den);
+        return false;
+    }
+
+    _time_base_num = num;
+    _time_base_den = den;
+    return true;
+}
+
+const AVCodec* video_writer::find_encoder() const
+{
+    if (_encoder.codec.empty())
+    {
+        const AVCodec* codec = avcodec_find_encoder(_format_ctx->oformat->video_codec);
+        if (!codec)
+            log_error("Could not find encoder for:", avcodec_get_name(_format_ctx->oformat->video_codec));
+
+        return codec;
+    }
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(_encoder.codec.c_str());
+    if (!codec || codec->type != AVMEDIA_TYPE_VIDEO)
+    {
+        log_error("Could not find video encoder:", _encoder.codec);
+        return nullptr;
+    }
+
+    // < 0: the muxer does not tell, let avformat_write_header decide.
+    if (avformat_query_codec(_format_ctx->oformat, codec->id, FF_COMPLIANCE_NORMAL) == 0)
+    {
+        log_error("Encoder not supported by the output format:", _encoder.codec, _format_ctx->oformat->name);
+        return nullptr;
+    }
+
+    return codec;
+}
+
+bool video_writer::add_stream(int fps)
+{
     if (_stream = avformat_new_stream(_format_ctx, nullptr); !_stream)
     {
-        log_error("avformat_new_stream", vio::logger::get().err2str(r));
+        log_error("avformat_new_stream");
         return false;
     }
     _stream->id = _format_ctx->nb_streams-1;
-    _stream->time_base = AVRational{ 1, fps }; // For fixed-fps content timebase should be 1/framerate
+    // For fixed-fps content timebase should be 1/framerate. A custom time base carries variable frame rate timestamps,
+    // fps is then only the nominal rate: the muxer derives each frame duration from the timestamps.
+    _stream->time_base = _time_base_den > 0 ? AVRational{ _time_base_num, _time_base_den } : AVRational{ 1, fps };
     _stream->r_frame_rate = AVRational{ fps, 1 };
     _stream->avg_frame_rate = AVRational{ fps, 1 };
+    return true;
+}
+
+bool video_writer::open_encoder(const AVCodec* codec)
+{
+    AVDictionary* options = nullptr;
+    for (const auto& [key, value] : _encoder.options)
+        av_dict_set(&options, key.c_str(), value.c_str(), 0);
+
+    if (!_encoder.preset.empty())
+        av_dict_set(&options, "preset", _encoder.preset.c_str(), 0);
+
+    if (!_encoder.tune.empty())
+        av_dict_set(&options, "tune", _encoder.tune.c_str(), 0);
+
+    if (_encoder.crf >= 0)
+        av_dict_set_int(&options, "crf", _encoder.crf, 0);
+
+    // Segments start on frames forced to AV_PICTURE_TYPE_I: make them IDR frames where the encoder tells apart (x264, x265).
+    const bool has_forced_idr = codec->priv_class && av_opt_find(const_cast<const AVClass**>(&codec->priv_class), "forced-idr", nullptr, 0, AV_OPT_SEARCH_FAKE_OBJ);
+    if (!_segments.pattern.empty() && has_forced_idr)
+        av_dict_set(&options, "forced-idr", "1", 0);
+
+    const auto r = avcodec_open2(_codec_ctx, codec, &options);
+
+    // avcodec_open2 leaves the options it did not consume in the dictionary.
+    for (auto* e = av_dict_get(options, "", nullptr, AV_DICT_IGNORE_SUFFIX); e; e = av_dict_get(options, "", e, AV_DICT_IGNORE_SUFFIX))
+        log_info("Encoder option ignored:", e->key, e->value);
+
+    av_dict_free(&options);
+    if (r < 0)
+    {
+        log_error("avcodec_open2", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    return true;
+}
+
+bool video_writer::init_stream(int width, int height, int fps)
+{
+    const AVCodec* codec = find_encoder();
+    if (!codec)
+        return false;
+
+    if (!add_stream(fps))
+        return false;
 
     if (_codec_ctx = avcodec_alloc_context3(codec); !_codec_ctx)
     {
@@ -94,14 +309,22 @@ bool video_writer::open(const std::string& video_path, int width, int height, co
     }
 
     _codec_ctx->codec_id = codec->id;
-    _codec_ctx->bit_rate = 400000;
+    _codec_ctx->bit_rate = _encoder.crf >= 0 ? 0 : _encoder.bit_rate; // CRF: quality driven, no target bit rate
+    _codec_ctx->rc_max_rate = _encoder.max_bit_rate;
+    _codec_ctx->rc_buffer_size = _encoder.rc_buffer_size;
     _codec_ctx->width = width - (width % 2); // Keep sizes a multiple of 2
     _codec_ctx->height = height - (height % 2);
     _codec_ctx->time_base = _stream->time_base;
-    _codec_ctx->gop_size = 12; // emit one intra frame every 12 frames at most
+    _codec_ctx->framerate = AVRational{ fps, 1 };
+    _codec_ctx->gop_size = _encoder.gop_size; // emit one intra frame every gop_size frames at most
     _codec_ctx->pix_fmt = AVPixelFormat::AV_PIX_FMT_YUV420P;
+    _codec_ctx->thread_count = _encoder.threads;
 
-    if (_codec_ctx->codec_id == AV_CODEC_ID_MPEG2VIDEO)
+    if (_encoder.max_b_frames >= 0)
+    {
+        _codec_ctx->max_b_frames = _encoder.max_b_frames;
+    }
+    else if (_codec_ctx->codec_id == AV_CODEC_ID_MPEG2VIDEO)
     {
         _codec_ctx->max_b_frames = 2;
     }
@@ -114,11 +337,8 @@ bool video_writer::open(const std::string& video_path, int width, int height, co
     if (_format_ctx->oformat->flags & AVFMT_GLOBALHEADER)
         _codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
 
-    if (auto r = avcodec_open2(_codec_ctx, codec, nullptr); r < 0)
-    {
-        log_error("avcodec_open2", vio::logger::get().err2str(r));
+    if (!open_encoder(codec))
         return false;
-    }
 
     if (_packet = av_packet_alloc(); !_packet)
     {
@@ -132,13 +352,11 @@ bool video_writer::open(const std::string& video_path, int width, int height, co
         return false;
     }
 
-    if (_codec_ctx->pix_fmt != AV_PIX_FMT_YUV420P)
+    // Wraps caller buffers that are already in the encoder layout, no pixel buffer of its own.
+    if (_tmp_frame = av_frame_alloc(); !_tmp_frame)
     {
-        if (_tmp_frame = alloc_frame(static_cast<int>(AVPixelFormat::AV_PIX_FMT_YUV420P), _codec_ctx->width, _codec_ctx->height); !_frame)
-        {
-            log_error("alloc_frame");
-            return false;
-        }
+        log_error("av_frame_alloc");
+        return false;
     }
 
     if (auto r = avcodec_parameters_from_context(_stream->codecpar, _codec_ctx); r < 0)
@@ -147,16 +365,12 @@ bool video_writer::open(const std::string& video_path, int width, int height, co
         return false;
     }
 
-    if (!(_format_ctx->oformat->flags & AVFMT_NOFILE)) 
-    {
-        if (auto r = avio_open(&_format_ctx->pb, video_path.c_str(), AVIO_FLAG_WRITE); r < 0) 
-        {
-            log_error("avio_open", vio::logger::get().err2str(r));
-            return false;
-        }
-    }
- 
-    if (auto r = avformat_write_header(_format_ctx, nullptr); r < 0) 
+    return true;
+}
+
+bool video_writer::write_header(AVDictionary** options)
+{
+    if (auto r = avformat_write_header(_format_ctx, options); r < 0) 
     {
         log_error("avformat_write_header", vio::logger::get().err2str(r));
         return false;
@@ -223,38 +437,161 @@ bool video_writer::encode(AVFrame* frame)
 
             return false;
         }
- 
-        av_packet_rescale_ts(_packet, _codec_ctx->time_base, _stream->time_base);
-        _packet->stream_index = _stream->index;
- 
-        // After the next line _packet is blank since av_interleaved_write_frame() takes ownership of its contents and resets it.
-        // Unreferencing is not necessary, i.e. no need to call av_packet_unref(_packet).
-        if (auto r = av_interleaved_write_frame(_format_ctx, _packet); r < 0)
-        {
-            log_info("av_interleaved_write_frame", vio::logger::get().err2str(r));
+
+        if (!write_packet(_packet))
             return false;
-        }
     }
 
     return true;
 }
 
-bool video_writer::convert(const uint8_t* data)
+bool video_writer::open_segment()
 {
-    if (_stream_duration > 0 && av_compare_ts(_next_pts, _codec_ctx->time_base, _stream_duration, AVRational{ 1, 1 }) >= 0)
+    char path[4096] = {};
+    if (av_get_frame_filename2(path, sizeof(path), _segments.pattern.c_str(), _segment_index, 0) < 0)
     {
-        log_info("End of stream. Flush remaining packets.");
-        encode(nullptr);
+        log_error("Invalid segment pattern, expected one printf integer (e.g. %05d):", _segments.pattern);
         return false;
     }
 
-    // when we pass a frame to the encoder, it may keep a reference to it internally; make sure we do not overwrite it here
-    if (auto r = av_frame_make_writable(_frame); r < 0)
+    _segment_path = path;
+    if (auto r = avformat_alloc_output_context2(&_format_ctx, nullptr, nullptr, path); r < 0)
     {
-        log_error("av_frame_make_writable", vio::logger::get().err2str(r));
+        log_error("avformat_alloc_output_context2", _segment_path, vio::logger::get().err2str(r));
+        return false;
+    }
+
+    return true;
+}
+
+bool video_writer::close_segment()
+{
+    // A failed rotation leaves no segment open.
+    if (!_format_ctx)
+        return false;
+
+    if (auto r = av_write_trailer(_format_ctx); r < 0)
+    {
+        log_error("av_write_trailer", _segment_path, vio::logger::get().err2str(r));
+        return false;
+    }
+
+    if (auto r = avio_closep(&_format_ctx->pb); r < 0)
+    {
+        log_error("avio_closep", _segment_path, vio::logger::get().err2str(r));
+        return false;
+    }
+
+    avformat_free_context(_format_ctx);
+    _format_ctx = nullptr;
+    _stream = nullptr;
+
+    log_info("Segment completed:", _segment_path);
+    if (_segments.on_segment)
+        _segments.on_segment(_segment_path);
+
+    return true;
+}
+
+bool video_writer::rotate_segment()
+{
+    if (!close_segment())
+        return false;
+
+    ++_segment_index;
+    if (!open_segment() || !add_stream(_codec_ctx->framerate.num))
+        return false;
+
+    // The encoder keeps running: the new header carries its current parameters and extradata.
+    if (auto r = avcodec_parameters_from_context(_stream->codecpar, _codec_ctx); r < 0)
+    {
+        log_error("avcodec_parameters_from_context", vio::logger::get().err2str(r));
         return false;
     }
 
+    if (auto r = avio_open(&_format_ctx->pb, _segment_path.c_str(), AVIO_FLAG_WRITE); r < 0)
+    {
+        log_error("avio_open", _segment_path, vio::logger::get().err2str(r));
+        return false;
+    }
+
+    if (auto r = avformat_write_header(_format_ctx, nullptr); r < 0)
+    {
+        log_error("avformat_write_header", _segment_path, vio::logger::get().err2str(r));
+        return false;
+    }
+
+    return true;
+}
+
+void video_writer::mark_segment_boundary(AVFrame* frame)
+{
+    // The writer frames are reused: clear the type forced at the previous boundary.
+    frame->pict_type = AV_PICTURE_TYPE_NONE;
+
+    const int64_t duration = av_rescale_q(_segments.duration.count(), AVRational{ 1, 1000 }, _codec_ctx->time_base);
+    if (_segment_boundary_pts == AV_NOPTS_VALUE)
+    {
+        _segment_boundary_pts = frame->pts + duration;
+        return;
+    }
+
+    if (frame->pts < _segment_boundary_pts)
+        return;
+
+    // First frame at or past the boundary: forced keyframe, its packet starts the next segment.
+    frame->pict_type = AV_PICTURE_TYPE_I;
+    _segment_splits.push_back(frame->pts);
+    _segment_boundary_pts = frame->pts + duration;
+}
+
+bool video_writer::write_packet(AVPacket* packet)
+{
+    // The forced keyframe of the next segment: earlier frames have all been written, since an IDR frame cannot be referenced across.
+    if (!_segment_splits.empty() && (packet->flags & AV_PKT_FLAG_KEY) && packet->pts >= _segment_splits.front())
+    {
+        while (!_segment_splits.empty() && _segment_splits.front() <= packet->pts)
+            _segment_splits.pop_front();
+
+        _segment_start_dts = AV_NOPTS_VALUE;
+        if (!rotate_segment())
+            return false;
+    }
+
+    // Shifted by the first dts of the segment rather than its first pts: with B-frames the first dts is
+    // below the first pts, and would go negative. The composition offset is kept, e.g. as an MP4 edit list.
+    if (!_segments.pattern.empty() && _segments.reset_timestamps)
+    {
+        if (_segment_start_dts == AV_NOPTS_VALUE)
+            _segment_start_dts = packet->dts;
+
+        packet->pts -= _segment_start_dts;
+        packet->dts -= _segment_start_dts;
+    }
+
+    av_packet_rescale_ts(packet, _codec_ctx->time_base, _stream->time_base);
+    packet->stream_index = _stream->index;
+
+    // After the next line packet is blank since av_interleaved_write_frame() takes ownership of its contents and resets it.
+    // Unreferencing is not necessary, i.e. no need to call av_packet_unref(packet).
+    if (auto r = av_interleaved_write_frame(_format_ctx, packet); r < 0)
+    {
+        log_info("av_interleaved_write_frame", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    return true;
+}
+
+AVFrame* video_writer::convert(const uint8_t* data, int64_t pts, AVFrame* dst)
+{
+    if (_stream_duration > 0 && av_compare_ts(pts, _codec_ctx->time_base, _stream_duration, AVRational{ 1, 1 }) >= 0)
+    {
+        log_info("End of stream. Flush remaining packets.");
+        encode(nullptr);
+        return nullptr;
+    }
+
     // /* Y */
     // for (int y = 0; y < _codec_ctx->height; y++)
     // {
@@ -274,57 +611,139 @@ bool video_writer::convert(const uint8_t* data)
     //     }
     // }
 
-    if (_codec_ctx->pix_fmt != AV_PIX_FMT_YUV420P)
+    const auto input_format = static_cast<AVPixelFormat>(get_input_format());
+    const auto [input_width, input_height] = get_input_size();
+
+    uint8_t* src_data[4] = {};
+    int src_linesize[4] = {};
+    const auto input_size = av_image_fill_arrays(src_data, src_linesize, data, input_format, input_width, input_height, 1);
+    if (input_size < 0)
     {
-        // as we only generate a YUV420P picture, we must convert it to the codec pixel format if needed 
-        if (!_sws_ctx) 
-        {
-            _sws_ctx = sws_getContext(
-                _codec_ctx->width, _codec_ctx->height, AVPixelFormat::AV_PIX_FMT_YUV420P,
-                _codec_ctx->width, _codec_ctx->height, _codec_ctx->pix_fmt, 
-                SWS_BICUBIC, nullptr, nullptr, nullptr);
-            
-            if (!_sws_ctx)
-            {
-                log_error("Unable to initialize SwsContext");
-                return false;
-            }
-        }
+        log_error("av_image_fill_arrays", vio::logger::get().err2str(input_size));
+        return nullptr;
+    }
 
-        if (auto r = av_image_fill_arrays(_tmp_frame->data, _tmp_frame->linesize, data, _codec_ctx->pix_fmt, _codec_ctx->width, _codec_ctx->height, 1); r < 0)
-        {
-            log_error("av_image_fill_arrays", vio::logger::get().err2str(r));
-            return false;
-        }
+    if (is_encoded_in_place())
+    {
+        if (!wrap_buffer(data, static_cast<size_t>(input_size), _tmp_frame))
+            return nullptr;
 
-        sws_scale(_sws_ctx, (const uint8_t * const *)_tmp_frame->data, _tmp_frame->linesize, 0, _codec_ctx->height, _frame->data, _frame->linesize);
+        _tmp_frame->pts = pts;
+        _next_pts = pts + 1;
+        return _tmp_frame;
     }
-    else 
+
+    AVFrame* frame = dst ? dst : _frame;
+
+    // when we pass a frame to the encoder, it may keep a reference to it internally; make sure we do not overwrite it here
+    if (auto r = av_frame_make_writable(frame); r < 0)
     {
-        if (auto r = av_image_fill_arrays(_frame->data, _frame->linesize, data, _codec_ctx->pix_fmt, _codec_ctx->width, _codec_ctx->height, 1); r < 0)
+        log_error("av_frame_make_writable", vio::logger::get().err2str(r));
+        return nullptr;
+    }
+
+    const bool is_same_layout = input_format == _codec_ctx->pix_fmt && input_width == _codec_ctx->width && input_height == _codec_ctx->height;
+    if (is_same_layout)
+    {
+        av_image_copy(frame->data, frame->linesize, const_cast<const uint8_t**>(src_data), src_linesize, input_format, input_width, input_height);
+    }
+    else
+    {
+        // Color conversion and resize to the encoder layout in a single pass.
+        _sws_ctx = sws_getCachedContext(_sws_ctx,
+            input_width, input_height, input_format,
+            _codec_ctx->width, _codec_ctx->height, _codec_ctx->pix_fmt,
+            to_sws_flags(_input.scaler), nullptr, nullptr, nullptr);
+
+        if (!_sws_ctx)
         {
-            log_error("av_image_fill_arrays", vio::logger::get().err2str(r));
-            return false;
+            log_error("Unable to initialize SwsContext");
+            return nullptr;
         }
+
+        sws_scale(_sws_ctx, src_data, src_linesize, 0, input_height, frame->data, frame->linesize);
     }
     
-    _frame->pts = _next_pts++; // Timestamp increment must be 1 for fixed-fps content
+    frame->pts = pts;
+    _next_pts = pts + 1;
     
+    return frame;
+}
+
+bool video_writer::is_encoded_in_place() const
+{
+    // Encoders without delay are done with the frame before write() returns: the caller buffer is encoded in place.
+    const auto [input_width, input_height] = get_input_size();
+    return get_input_format() == _codec_ctx->pix_fmt && input_width == _codec_ctx->width && input_height == _codec_ctx->height
+        && !(_codec_ctx->codec->capabilities & (AV_CODEC_CAP_DELAY | AV_CODEC_CAP_FRAME_THREADS));
+}
+
+bool video_writer::wrap_buffer(const uint8_t* data, size_t size, AVFrame* dst)
+{
+    av_frame_unref(dst);
+    dst->format = _codec_ctx->pix_fmt;
+    dst->width  = _codec_ctx->width;
+    dst->height = _codec_ctx->height;
+
+    if (auto r = av_image_fill_arrays(dst->data, dst->linesize, data, _codec_ctx->pix_fmt, dst->width, dst->height, 1); r < 0)
+    {
+        log_error("av_image_fill_arrays", vio::logger::get().err2str(r));
+        return false;
+    }
+
+    // The caller owns the memory: the buffer reference only makes the frame refcounted, so that the encoder does not copy it.
+    if (dst->buf[0] = av_buffer_create(const_cast<uint8_t*>(data), size, [](void*, uint8_t*){}, nullptr, AV_BUFFER_FLAG_READONLY); !dst->buf[0])
+    {
+        log_error("av_buffer_create");
+        return false;
+    }
+
     return true;
 }
 
+int video_writer::get_input_format() const
+{
+    // native: frames are already in the encoder pixel format.
+    return _input.format == pixel_format::native ? _codec_ctx->pix_fmt : to_av_pixel_format(_input.format);
+}
+
+std::tuple<int, int> video_writer::get_input_size() const
+{
+    return { _input.width > 0 ? _input.width : _codec_ctx->width, _input.height > 0 ? _input.height : _codec_ctx->height };
+}
+
 bool video_writer::write(const uint8_t* data)
+{
+    // Timestamp increment must be 1 for fixed-fps content
+    return write(data, _next_pts);
+}
+
+bool video_writer::write(const uint8_t* data, int64_t pts)
 {
     if(!_is_opened)
         return false;
+
+    // Encoders and muxers reject timestamps going backward or repeated.
+    if(pts < _next_pts)
+    {
+        log_error("write: pts must be strictly increasing:", "pts:", pts, "previous pts:", _next_pts - 1);
+        return false;
+    }
         
-    if(!convert(data))
+    AVFrame* frame = convert(data, pts);
+    if(!frame)
         return false;
 
-    if(!encode(_frame))
-        return false;
+    if (!_segments.pattern.empty())
+        mark_segment_boundary(frame);
 
-    return true;
+    const bool is_encoded = encode(frame);
+
+    // Drop the reference to the caller buffer as soon as the encoder is done with it.
+    if(frame == _tmp_frame)
+        av_frame_unref(_tmp_frame);
+
+    return is_encoded;
 }
 
 bool video_writer::save()
@@ -334,13 +753,30 @@ bool video_writer::save()
 
     encode(nullptr);
 
+    if (!_segments.pattern.empty())
+    {
+        if (!close_segment())
+            return false;
+
+        return release();
+    }
+
     if(auto r = av_write_trailer(_format_ctx); r < 0) 
     {
         log_error("avformat_write_header", vio::logger::get().err2str(r));
         return false;
     }
 
-    if (!(_format_ctx->oformat->flags & AVFMT_NOFILE))
+    if (_sink_io)
+    {
+        // Push what is left in the AVIO buffer to the sink, the AVIOContext itself is freed on release.
+        if (!_sink_io->flush())
+        {
+            log_error("Unable to flush output sink");
+            return false;
+        }
+    }
+    else if (!(_format_ctx->oformat->flags & AVFMT_NOFILE))
     {
         if (auto r = avio_closep(&_format_ctx->pb); r < 0) 
         {
@@ -374,9 +810,15 @@ bool video_writer::release()
     if(_sws_ctx)
         sws_freeContext(_sws_ctx);
 
+    // Released without save(): the segment being written still has its file open.
+    if(_format_ctx && !_segments.pattern.empty())
+        avio_closep(&_format_ctx->pb);
+
     if(_format_ctx)
         avformat_free_context(_format_ctx);
 
+    _sink_io.reset();
+
     init();
     return true;
 }
@@ -0,0 +1,120 @@
+#include "logger.hpp"
+#include "video_writer_sink.hpp"
+
+extern "C"
+{
+#include <libavformat/avio.h>
+#include <libavutil/mem.h>
+}
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace vio
+{
+video_writer::sink_io::sink_io(const output_sink& sink)
+: sink{ sink }
+, avio_ctx{ nullptr }
+{
+}
+
+video_writer::sink_io::~sink_io()
+{
+    release();
+}
+
+bool video_writer::sink_io::init()
+{
+    // The buffer belongs to the AVIOContext from now on: FFmpeg may reallocate it, hence av_malloc.
+    auto* buffer = static_cast<unsigned char*>(av_malloc(sink.buffer_size));
+    if (!buffer)
+    {
+        log_error("av_malloc");
+        return false;
+    }
+
+    avio_ctx = avio_alloc_context(buffer, sink.buffer_size, 1, this, nullptr, &sink_io::write_packet, sink.seek ? &sink_io::seek : nullptr);
+    if (!avio_ctx)
+    {
+        log_error("avio_alloc_context");
+        av_free(buffer);
+        return false;
+    }
+
+    return true;
+}
+
+bool video_writer::sink_io::flush()
+{
+    if (!avio_ctx)
+        return false;
+
+    avio_flush(avio_ctx);
+    return avio_ctx->error >= 0;
+}
+
+void video_writer::sink_io::release()
+{
+    if (!avio_ctx)
+        return;
+
+    av_freep(&avio_ctx->buffer);
+    avio_context_free(&avio_ctx);
+}
+
+int video_writer::sink_io::write_packet(void* opaque, uint8_t* buffer, int size)
+{
+    auto* self = static_cast<sink_io*>(opaque);
+    const int count = self->sink.write(buffer, size);
+    return count < 0 ? AVERROR(EIO) : count;
+}
+
+int64_t video_writer::sink_io::seek(void* opaque, int64_t offset, int whence)
+{
+    // Output sizes are unknown until the trailer is written.
+    if (whence & AVSEEK_SIZE)
+        return AVERROR(ENOSYS);
+
+    auto* self = static_cast<sink_io*>(opaque);
+    const auto position = self->sink.seek(offset, whence & ~AVSEEK_FORCE);
+    return position < 0 ? AVERROR(EIO) : position;
+}
+
+output_sink memory_sink(std::vector<uint8_t>& buffer, const std::string& format)
+{
+    // The write position is shared by the write and seek callbacks: muxers seek back to patch headers.
+    buffer.clear();
+    auto position = std::make_shared<size_t>(0);
+
+    output_sink sink{ format };
+    sink.write = [&buffer, position](const uint8_t* data, int size)
+    {
+        if (buffer.size() < *position + size)
+            buffer.resize(*position + size);
+
+        std::memcpy(buffer.data() + *position, data, size);
+        *position += size;
+        return size;
+    };
+
+    sink.seek = [&buffer, position](int64_t offset, int whence) -> int64_t
+    {
+        int64_t origin = 0;
+        if (whence == SEEK_CUR)
+            origin = static_cast<int64_t>(*position);
+        else if (whence == SEEK_END)
+            origin = static_cast<int64_t>(buffer.size());
+
+        const int64_t target = origin + offset;
+        if (target < 0)
+            return -1;
+
+        *position = static_cast<size_t>(target);
+        return target;
+    };
+
+    return sink;
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <video_io/video_writer.hpp>
+
+struct AVIOContext;
+
+namespace vio
+{
+/**
+ * AVIOContext writing through output_sink callbacks instead of a file.
+*/
+struct video_writer::sink_io
+{
+    explicit sink_io(const output_sink& sink);
+    ~sink_io();
+
+    bool init();
+    bool flush();
+    void release();
+
+    static int write_packet(void* opaque, uint8_t* buffer, int size);
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+
+    output_sink sink;
+    AVIOContext* avio_ctx;
+};
+
+}